@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _ASYNC_FILE_IO_H_
+#define _ASYNC_FILE_IO_H_
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+#include "FileObject.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// io_uring based asynchronous I/O for file objects. Submission never
+	/// waits on the device, completions are collected by polling or from a
+	/// separate thread and reported through an optional callback taking the
+	/// number of bytes transferred or a negative error number.
+	/// </summary>
+
+	class AsyncFileIO
+	{
+	public:
+
+		using Completion = std::function<void (int32_t result)>;
+
+		static constexpr uint32_t DefaultQueueDepth = 64;
+		static constexpr off_t CurrentPosition = -1;
+
+		AsyncFileIO () noexcept;
+		virtual ~AsyncFileIO () noexcept;
+
+		AsyncFileIO (const AsyncFileIO& from) = delete;
+		AsyncFileIO (AsyncFileIO&& from) = delete;
+		AsyncFileIO& operator = (const AsyncFileIO& from) = delete;
+		AsyncFileIO& operator = (AsyncFileIO&& from) = delete;
+
+		[[nodiscard]] bool IsOpen () const noexcept { return m_ringHandle != INVALID_HANDLE_VALUE; }
+		[[nodiscard]] bool Initialise (uint32_t queueDepth = DefaultQueueDepth) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] bool SubmitWrite (const FileObject& fileObject, const uint8_t* pBuffer, size_t length,
+			off_t offset = CurrentPosition, Completion completion = nullptr) noexcept;
+		[[nodiscard]] bool SubmitRead (const FileObject& fileObject, uint8_t* pBuffer, size_t length,
+			off_t offset = CurrentPosition, Completion completion = nullptr) noexcept;
+		[[nodiscard]] bool SubmitSync (const FileObject& fileObject, bool dataOnly = true, Completion completion = nullptr) noexcept;
+
+		uint32_t ProcessCompletions () noexcept;
+		uint32_t WaitCompletions (uint32_t minimum = 1) noexcept;
+
+		[[nodiscard]] int32_t GetEventHandle () const noexcept { return m_eventHandle; }
+		[[nodiscard]] uint32_t GetPending () const noexcept { return m_pending; }
+
+	private:
+
+		static constexpr int32_t INVALID_HANDLE_VALUE = -1;
+
+		struct Request
+		{
+			Completion				m_completion;
+			std::vector<uint8_t>	m_data;
+			int32_t					m_result;
+		};
+
+		[[nodiscard]] io_uring_sqe* NextSubmission (uint32_t& slotIndex) noexcept;
+		[[nodiscard]] bool Submit (uint32_t slotIndex) noexcept;
+
+		std::mutex				m_ringMutex;
+		std::mutex				m_completeMutex;
+		std::vector<Request>	m_requests;
+		std::vector<uint32_t>	m_freeSlots;
+		std::vector<uint32_t>	m_completedSlots;
+
+		int32_t			m_ringHandle;
+		int32_t			m_eventHandle;
+		std::atomic<uint32_t>	m_pending;
+
+		void*			m_pSubmitRing;
+		size_t			m_submitRingSize;
+		void*			m_pCompleteRing;
+		size_t			m_completeRingSize;
+		io_uring_sqe*	m_pSubmitEntries;
+		size_t			m_submitEntriesSize;
+
+		uint32_t*		m_pSubmitHead;
+		uint32_t*		m_pSubmitTail;
+		uint32_t*		m_pSubmitArray;
+		uint32_t		m_submitMask;
+		uint32_t		m_submitEntryCount;
+
+		uint32_t*		m_pCompleteHead;
+		uint32_t*		m_pCompleteTail;
+		io_uring_cqe*	m_pCompleteEntries;
+		uint32_t		m_completeMask;
+	};
+}
+
+#endif
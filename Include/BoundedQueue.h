@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _BOUNDED_QUEUE_H_
+#define _BOUNDED_QUEUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+/////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Fixed capacity lock free queue for any number of producers and
+	/// consumers. Each cell carries a sequence number that tells a producer
+	/// or consumer whether it is free or full, so neither side ever blocks
+	/// and a full queue simply refuses the item. The capacity is rounded up to
+	/// a power of two.
+	/// </summary>
+
+	template<typename T>
+	class BoundedQueue
+	{
+		static_assert (std::is_trivially_copyable_v<T>, "Queue items are copied in and out so must be trivially copyable");
+
+	public:
+
+		static constexpr size_t CacheLineSize = 64;
+
+		BoundedQueue (size_t capacity) :
+			m_pCells (std::make_unique<Cell[]> (std::bit_ceil (std::max<size_t> (capacity, 2)))),
+			m_mask (std::bit_ceil (std::max<size_t> (capacity, 2)) - 1),
+			m_enqueuePosition (0),
+			m_dequeuePosition (0)
+		{
+			for (size_t index = 0; index <= m_mask; ++index) m_pCells[index].sequence.store (index, std::memory_order_relaxed);
+		}
+
+		virtual ~BoundedQueue () = default;
+		BoundedQueue (const BoundedQueue& from) = delete;
+		BoundedQueue (BoundedQueue&& from) = delete;
+		BoundedQueue& operator = (const BoundedQueue& from) = delete;
+		BoundedQueue& operator = (BoundedQueue&& from) = delete;
+
+		[[nodiscard]] bool TryPush (const T& item) noexcept
+		{
+			size_t position = m_enqueuePosition.load (std::memory_order_relaxed);
+
+			while (true)
+			{
+				Cell& cell = m_pCells[position & m_mask];
+				size_t sequence = cell.sequence.load (std::memory_order_acquire);
+				ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+
+				if (difference == 0)
+				{
+					if (m_enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+					{
+						cell.item = item;
+						cell.sequence.store (position + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = m_enqueuePosition.load (std::memory_order_relaxed);
+				}
+			}
+		}
+
+		[[nodiscard]] bool TryPop (T& item) noexcept
+		{
+			size_t position = m_dequeuePosition.load (std::memory_order_relaxed);
+
+			while (true)
+			{
+				Cell& cell = m_pCells[position & m_mask];
+				size_t sequence = cell.sequence.load (std::memory_order_acquire);
+				ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position + 1);
+
+				if (difference == 0)
+				{
+					if (m_dequeuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+					{
+						item = cell.item;
+						cell.sequence.store (position + m_mask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = m_dequeuePosition.load (std::memory_order_relaxed);
+				}
+			}
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Only a snapshot while other threads are pushing and popping
+
+		[[nodiscard]] size_t Size () const noexcept
+		{
+			size_t dequeuePosition = m_dequeuePosition.load (std::memory_order_relaxed);
+			size_t enqueuePosition = m_enqueuePosition.load (std::memory_order_relaxed);
+			return (enqueuePosition > dequeuePosition) ? enqueuePosition - dequeuePosition : 0;
+		}
+
+		[[nodiscard]] size_t Capacity () const noexcept { return m_mask + 1; }
+
+	private:
+
+		struct Cell
+		{
+			std::atomic<size_t>	sequence;
+			T					item;
+		};
+
+		std::unique_ptr<Cell[]>	m_pCells;
+		const size_t			m_mask;
+
+		// Producers and consumers each keep to their own cache line
+		alignas (CacheLineSize) std::atomic<size_t>	m_enqueuePosition;
+		alignas (CacheLineSize) std::atomic<size_t>	m_dequeuePosition;
+	};
+}
+
+#endif
@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_ASYNC_WRITER_H_
+#define _CSV_ASYNC_WRITER_H_
+
+#include "BoundedQueue.h"
+#include "CSVFile.h"
+#include "Thread.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// One row of binary values waiting to be written. Columns are set by the
+	/// same index as the CSVColumnCollection, fixed Row, Date and Time columns
+	/// are filled in by the writer. String values share a small text area and
+	/// are truncated if it fills up.
+	/// </summary>
+
+	class CSVRecord
+	{
+	public:
+
+		static constexpr size_t MaximumColumns = 32;
+		static constexpr size_t MaximumTextSize = 128;
+
+		CSVRecord () noexcept { Clear (); }
+
+		void Clear () noexcept
+		{
+			m_time = timespec {};
+			m_values.fill (Value {});
+			m_textUsed = 0;
+		}
+
+		void SetIntegerAt (uint8_t index, int32_t value) noexcept
+		{
+			if (index < MaximumColumns) m_values[index].integer = value;
+		}
+
+		void SetFloatAt (uint8_t index, float value) noexcept
+		{
+			if (index < MaximumColumns) m_values[index].real = value;
+		}
+
+		void SetStringAt (uint8_t index, std::string_view text) noexcept
+		{
+			if (index >= MaximumColumns) return;
+
+			text = text.substr (0, MaximumTextSize - m_textUsed);
+			std::memcpy (m_text + m_textUsed, text.data (), text.length ());
+
+			m_values[index].text = {static_cast<uint8_t>(m_textUsed), static_cast<uint8_t>(text.length ())};
+			m_textUsed += text.length ();
+		}
+
+		[[nodiscard]] int32_t GetIntegerAt (uint8_t index) const noexcept { return (index < MaximumColumns) ? m_values[index].integer : 0; }
+		[[nodiscard]] float GetFloatAt (uint8_t index) const noexcept { return (index < MaximumColumns) ? m_values[index].real : 0.0f; }
+
+		[[nodiscard]] std::string_view GetStringAt (uint8_t index) const noexcept
+		{
+			if (index >= MaximumColumns) return {};
+			return std::string_view (m_text + m_values[index].text.offset, m_values[index].text.length);
+		}
+
+		[[nodiscard]] const timespec& GetTime () const noexcept { return m_time; }
+		void SetTime (const timespec& time) noexcept { m_time = time; }
+
+	private:
+
+		struct TextRange
+		{
+			uint8_t	offset;
+			uint8_t	length;
+		};
+
+		union Value
+		{
+			int32_t		integer;
+			float		real;
+			TextRange	text;
+		};
+
+		static_assert (MaximumTextSize <= UINT8_MAX, "Text offsets are held in a byte");
+
+		timespec							m_time;
+		std::array<Value, MaximumColumns>	m_values;
+		char								m_text[MaximumTextSize];
+		size_t								m_textUsed;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Counters for an asynchronous writer, read while it runs
+	/// </summary>
+
+	struct CSVAsyncStatistics
+	{
+		uint64_t	pushed = 0;
+		uint64_t	dropped = 0;
+		uint64_t	written = 0;
+		uint64_t	failed = 0;
+		uint64_t	batches = 0;
+		size_t		highWater = 0;
+		size_t		capacity = 0;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// CSVWriter run on its own thread. Producers copy a CSVRecord into a
+	/// lock free queue and return at once, a full queue drops the record
+	/// rather than blocking. The writer thread formats whatever is queued
+	/// through the column collection and writes it as one batch.
+	/// </summary>
+
+	class CSVAsyncWriter : private Thread
+	{
+	public:
+
+		static constexpr size_t DefaultQueueSize = 4096;
+		static constexpr size_t DefaultBatchSize = 256;
+		static constexpr size_t WriteBufferSize = 64 * 1024;
+		static constexpr uint32_t WriterDelayus = 1000;
+
+		CSVAsyncWriter (CSVColumnCollection& columnCollection, size_t queueSize = DefaultQueueSize);
+		virtual ~CSVAsyncWriter ();
+
+		CSVAsyncWriter (const CSVAsyncWriter& from) = delete;
+		CSVAsyncWriter (CSVAsyncWriter&& from) = delete;
+		CSVAsyncWriter& operator = (const CSVAsyncWriter& from) = delete;
+		CSVAsyncWriter& operator = (CSVAsyncWriter&& from) = delete;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Opens the file, writes the header if asked and starts the writer
+		/// thread. Close stops the thread once the queue has been written out.
+
+		[[nodiscard]] bool Open (const std::string& filePath, bool append = true, bool writeHeader = false, off_t reserveBytes = 0);
+		void Close ();
+
+		////////////////////////////////////////////////////////////////////////
+		/// Safe from any thread, the record is stamped with the current time
+
+		[[nodiscard]] bool Push (const CSVRecord& record) noexcept;
+
+		void SetBatchSize (size_t batchSize) noexcept { m_batchSize = std::max<size_t> (batchSize, 1); }
+		[[nodiscard]] CSVAsyncStatistics GetStatistics () const noexcept;
+
+	private:
+
+		TaskAction ThreadMethod () noexcept override;
+		void ThreadStop () noexcept override;
+
+		[[nodiscard]] size_t WriteBatch (size_t maximumRecords) noexcept;
+		void UpdateHighWater (size_t queueSize) noexcept;
+
+		CSVColumnCollection&	m_columnCollection;
+		CSVWriter				m_writer;
+		BoundedQueue<CSVRecord>	m_queue;
+		std::string				m_text;
+		size_t					m_batchSize;
+		bool					m_isOpen;
+
+		std::atomic<uint64_t>	m_pushed;
+		std::atomic<uint64_t>	m_dropped;
+		std::atomic<uint64_t>	m_written;
+		std::atomic<uint64_t>	m_failed;
+		std::atomic<uint64_t>	m_batches;
+		std::atomic<size_t>		m_highWater;
+	};
+}
+
+#endif
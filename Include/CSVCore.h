@@ -28,6 +28,7 @@
 #include <vector>
 
 #include "Clock.h"
+#include "CSVFormat.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -54,11 +55,15 @@ namespace spc
 		void Format (int32_t value);
 		void Format (float value);
 		void FormatFixed (uint32_t rowNumber);
+		void FormatFixed (uint32_t rowNumber, const CSVTimestamp& rowTime);
 
 		double GetValueAsDouble () const noexcept;
 		float GetValueAsFloat () const noexcept;
 		int GetValueAsInt () const noexcept;
 
+		template <typename T>
+		[[nodiscard]] CSVResult<T> GetValueAs () const noexcept { return CSVFormat::ParseValue<T> (m_formattedText); }
+
 		const std::string& GetValueAsText () const noexcept {return m_formattedText;}
 		const std::string& GetName () const noexcept {return m_columnName;}
 		uint8_t GetPrecision () const noexcept {return m_precision;}
@@ -69,15 +74,15 @@ namespace spc
 		void SetFormattedText (const std::string& formattedText) noexcept { m_formattedText = formattedText; }
 		void Clear () noexcept { m_formattedText.clear (); }
 
-	private:
+		bool IsLeftJustified () const noexcept {return m_leftJustified;}
 
-		static constexpr uint32_t TEMPORARY_BUFFER_SIZE = 32;
+	private:
 
 		std::string	m_columnName;
-		std::string m_formatText;
 		std::string m_formattedText;
 		uint8_t		m_precision;
 		uint8_t		m_width;
+		bool		m_leftJustified;
 		Type		m_type;
 	};
 
@@ -132,16 +137,30 @@ namespace spc
 		}
 
 		void SetFixedColumns ()
+		{
+			timespec now {};
+			clock_gettime (CLOCK_REALTIME, &now);
+			SetFixedColumns (now);
+		}
+
+		void SetFixedColumns (time_t rowTime)
+		{
+			SetFixedColumns (timespec {rowTime, 0});
+		}
+
+		void SetFixedColumns (const timespec& rowTime)
 		{
 			++m_rowNumber;
+			m_timestamp.Update (rowTime);
 			for (CSVColumn& item : m_vecColumns)
-				item.FormatFixed (m_rowNumber);
+				item.FormatFixed (m_rowNumber, m_timestamp);
 		}
 
 	private:
 
 		std::vector<CSVColumn>	m_vecColumns;
 		uint32_t				m_rowNumber;
+		CSVTimestamp			m_timestamp;
 	};
 
 	////////////////////////////////////////////////////////////////////////////
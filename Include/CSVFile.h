@@ -25,18 +25,31 @@
 #define _CSV_FILE_H_
 
 #include "CSVCore.h"
+#include "CSVFormat.h"
+#include "CSVIndex.h"
 #include "FileObject.h"
+#include "MappedFile.h"
+
+#include <functional>
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
 
 namespace spc
 {
+	class CSVRollupWriter;
+
 	class CSVWriter : public CSVCore
 	{
 	public:
 
-		CSVWriter (CSVColumnCollection& columnCollection) : CSVCore (columnCollection)
+		CSVWriter (CSVColumnCollection& columnCollection) : CSVCore (columnCollection),
+			m_fileOffset (0),
+			m_writeBackOffset (0),
+			m_releaseChunk (0),
+			m_lineCount (0),
+			m_indexInterval (0),
+			m_pRollupWriter (nullptr)
 		{
 		}
 		virtual ~CSVWriter () = default;
@@ -46,17 +59,59 @@ namespace spc
 		CSVWriter& operator = (const CSVWriter& from);
 		CSVWriter& operator = (const CSVWriter&& from) = delete;
 
-		[[nodiscard]] bool Open (const std::string& filePath, bool append = true) noexcept;
+		[[nodiscard]] bool Open (const std::string& filePath, bool append = true, off_t reserveBytes = 0) noexcept;
 		void Close (bool flush = false) noexcept;
 
 		[[nodiscard]] bool WriteHeader () noexcept;
 		[[nodiscard]] bool WriteLine () noexcept;
+		[[nodiscard]] bool WriteLine (time_t rowTime) noexcept { return WriteLine (timespec {rowTime, 0}); }
+		[[nodiscard]] bool WriteLine (const timespec& rowTime) noexcept;
+		[[nodiscard]] bool Flush () noexcept { return m_fileObject.Flush (); }
+
+		void SetWriteBuffer (size_t bufferSize, uint32_t flushIntervalms = 0) noexcept
+		{
+			m_fileObject.SetWriteBuffer (bufferSize, flushIntervalms);
+		}
+
+		[[nodiscard]] uint64_t GetSyscallCount () const noexcept { return m_fileObject.GetSyscallCount (); }
+
+		void SetCacheRelease (off_t chunkBytes) noexcept { m_releaseChunk = chunkBytes; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Keeps a CSVIndex entry for every Nth row when set before Open, zero
+		/// turns the index off
+
+		void SetIndexInterval (uint32_t rowInterval) noexcept { m_indexInterval = rowInterval; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Every row written is also added to the rollup writer, which must
+		/// share the column collection, nullptr detaches it
+
+		void SetRollupWriter (CSVRollupWriter* pRollupWriter) noexcept { m_pRollupWriter = pRollupWriter; }
 
 	private:
 
 		static constexpr const std::string_view CommaSeparator = ", ";
+		static constexpr const std::string_view NewLine = "\r\n";
+
+		void AddVector (const std::string_view& text)
+		{
+			m_rowVectors.push_back ({const_cast<char*>(text.data ()), text.length ()});
+			m_fileOffset += text.length ();
+		}
+
+		void ReleaseCache () noexcept;
+		[[nodiscard]] bool OpenIndex (const std::string& filePath) noexcept;
 
-		ASCIIFileObject	m_fileObject;
+		ASCIIFileObject		m_fileObject;
+		CSVIndex			m_index;
+		std::vector<iovec>	m_rowVectors;
+		off_t				m_fileOffset;
+		off_t				m_writeBackOffset;
+		off_t				m_releaseChunk;
+		uint64_t			m_lineCount;
+		uint32_t			m_indexInterval;
+		CSVRollupWriter*	m_pRollupWriter;
 	};
 
 	////////////////////////////////////////////////////////////////////////////
@@ -66,7 +121,11 @@ namespace spc
 	{
 	public:
 
-		CSVReader (CSVColumnCollection& columnCollection) : CSVCore (columnCollection)
+		CSVReader (CSVColumnCollection& columnCollection) : CSVCore (columnCollection),
+			m_scanStart (0),
+			m_scanEnd (0),
+			m_delimiterIndex (0),
+			m_indexLoaded (false)
 		{
 		}
 		virtual ~CSVReader () = default;
@@ -77,16 +136,125 @@ namespace spc
 		CSVReader& operator = (const CSVReader&& from) = delete;
 
 		[[nodiscard]] bool Open (const std::string& filePath) noexcept;
+		[[nodiscard]] bool OpenMapped (const std::string& filePath) noexcept;
 		void Close () noexcept;
 
 		[[nodiscard]] bool ReadHeader () noexcept;
 		[[nodiscard]] bool ReadLine () noexcept;
 
+		////////////////////////////////////////////////////////////////////////
+		/// Limits reading to the given columns, by index or by the names in
+		/// the column collection, so after ReadHeader for names taken from the
+		/// file. Other fields read as empty, ReadLine leaves them clear and a
+		/// line is not split past the last selected column. The Date and Time
+		/// columns are always kept for seeking by time.
+
+		[[nodiscard]] bool SelectColumns (const std::vector<uint32_t>& columns) noexcept;
+		[[nodiscard]] bool SelectColumnNames (const std::vector<std::string>& columnNames) noexcept;
+		void SelectAllColumns () noexcept { m_selected.clear (); }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Zero copy reading, the fields are views into the mapping or the line
+		/// buffer and remain valid until the next read. The column collection
+		/// is not touched.
+
+		[[nodiscard]] bool ReadFields () noexcept;
+		[[nodiscard]] size_t GetFieldCount () const noexcept { return m_fields.size (); }
+
+		[[nodiscard]] std::string_view GetField (size_t index) const noexcept
+		{
+			return (index < m_fields.size ()) ? m_fields[index] : std::string_view ();
+		}
+
+		template <typename T>
+		[[nodiscard]] bool GetFieldAs (size_t index, T& value) const noexcept
+		{
+			return CSVFormat::Parse (GetField (index), value);
+		}
+
+		template <typename T>
+		[[nodiscard]] CSVResult<T> GetFieldAs (size_t index) const noexcept
+		{
+			if (index >= m_fields.size ()) return CSVParseError::MissingField;
+			return CSVFormat::ParseValue<T> (m_fields[index]);
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Converts the fields of the last row read into typed values, one
+		/// per tuple element starting at the first column
+
+		template <typename... Types>
+		[[nodiscard]] CSVRowStatus GetRowAs (std::tuple<Types...>& values) const noexcept
+		{
+			return CSVFormat::ParseRow (m_fields, values);
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Positions the reader so the next read returns the row, counting
+		/// rows as CSVIndex does, or the first row at or after the time. The
+		/// sidecar index is used when there is one, otherwise the file is read
+		/// from the start. Seeking by time needs a Date and a Time column.
+
+		[[nodiscard]] bool SeekToRow (uint64_t row) noexcept;
+		[[nodiscard]] bool SeekToTime (time_t time) noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Calls the handler for each row with start <= time < end, the row's
+		/// fields are available through GetField. The handler returns false
+		/// to stop early. Returns false if no row is at or after the start.
+
+		using RowHandler = std::function<bool (const CSVReader& reader, time_t rowTime)>;
+
+		[[nodiscard]] bool QueryTimeRange (time_t start, time_t end, const RowHandler& handler) noexcept;
+
 	private:
 
 		static constexpr const char Comma = ',';
+		static constexpr size_t ScanWindowSize = 64 * 1024;
+		static constexpr off_t LinearSearchSize = 16 * 1024;
+
+		[[nodiscard]] bool ReadMappedFields () noexcept;
+		[[nodiscard]] size_t NextDelimiter (size_t offset) noexcept;
+		void ResetScan () noexcept;
+
+		void LoadIndex () noexcept;
+		[[nodiscard]] bool SeekToOffset (off_t offset) noexcept;
+		[[nodiscard]] off_t GetReadOffset () noexcept;
+		[[nodiscard]] bool SkipLine () noexcept;
+		[[nodiscard]] bool FindTimeColumns (uint32_t& dateColumn, uint32_t& timeColumn) noexcept;
+		[[nodiscard]] bool ReadFieldsTime (uint32_t dateColumn, uint32_t timeColumn, off_t& lineOffset, time_t& rowTime, bool& readValid) noexcept;
+		[[nodiscard]] off_t SearchTime (time_t time, off_t lowOffset, off_t highOffset, uint32_t dateColumn, uint32_t timeColumn) noexcept;
+		[[nodiscard]] off_t GetFileSize () noexcept;
+
+		[[nodiscard]] bool IsSelected (size_t index) const noexcept
+		{
+			return m_selected.empty () || (index < m_selected.size () && m_selected[index]);
+		}
+
+		[[nodiscard]] bool IsLineComplete () const noexcept
+		{
+			return !m_selected.empty () && m_fields.size () >= m_selected.size ();
+		}
+
+		void AddField (std::string_view field)
+		{
+			m_fields.push_back (IsSelected (m_fields.size ()) ? CSVFormat::Trim (field) : std::string_view ());
+		}
 
-		ASCIIFileObject	m_fileObject;
+		ASCIIFileObject					m_fileObject;
+		MappedFile						m_mappedFile;
+		std::string						m_lineBuffer;
+		std::string						m_fieldText;
+		std::vector<std::string_view>	m_fields;
+		std::vector<uint32_t>			m_delimiters;
+		std::vector<bool>				m_selected;
+		size_t							m_scanStart;
+		size_t							m_scanEnd;
+		size_t							m_delimiterIndex;
+		std::string						m_filePath;
+		CSVIndex						m_index;
+		CSVTimeParser					m_timeParser;
+		bool							m_indexLoaded;
 	};
 }
 
@@ -0,0 +1,466 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_FORMAT_H_
+#define _CSV_FORMAT_H_
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	enum class CSVParseError : uint8_t {None, Empty, Invalid, OutOfRange, Trailing, MissingField};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// A parsed value or the reason there is none, in the manner of
+	/// std::expected which is not available before C++23
+	/// </summary>
+
+	template <typename T>
+	class CSVResult
+	{
+	public:
+
+		CSVResult (T value) noexcept : m_value (std::move (value)), m_error (CSVParseError::None) {}
+		CSVResult (CSVParseError error) noexcept : m_value (), m_error (error) {}
+
+		[[nodiscard]] bool HasValue () const noexcept { return m_error == CSVParseError::None; }
+		[[nodiscard]] explicit operator bool () const noexcept { return HasValue (); }
+
+		[[nodiscard]] const T& GetValue () const noexcept { return m_value; }
+		[[nodiscard]] const T& operator * () const noexcept { return m_value; }
+		[[nodiscard]] T ValueOr (T otherValue) const noexcept { return HasValue () ? m_value : otherValue; }
+
+		[[nodiscard]] CSVParseError GetError () const noexcept { return m_error; }
+
+	private:
+
+		T				m_value;
+		CSVParseError	m_error;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Outcome of parsing a row, the column is the first one that failed
+	/// </summary>
+
+	struct CSVRowStatus
+	{
+		[[nodiscard]] explicit operator bool () const noexcept { return m_error == CSVParseError::None; }
+
+		CSVParseError	m_error;
+		size_t			m_column;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Allocation free field formatting with printf style width, precision and
+	/// justification. Each call writes into a caller supplied buffer of at least
+	/// MaximumFieldSize characters and returns the number of characters written.
+	/// </summary>
+
+	class CSVFormat
+	{
+	public:
+
+		static constexpr size_t MaximumFieldSize = 320;
+
+		CSVFormat () = delete;
+
+		////////////////////////////////////////////////////////////////////////
+		/// As "%W.Pd", precision is the minimum number of digits
+
+		static size_t FormatInteger (char* pDst, int64_t value, uint8_t width, uint8_t precision, bool leftJustified) noexcept
+		{
+			char digits[24];
+			uint64_t magnitude = (value < 0) ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+			size_t digitCount = static_cast<size_t>(std::to_chars (digits, digits + sizeof (digits), magnitude).ptr - digits);
+
+			// printf prints no digits at all for a zero with zero precision
+			if (magnitude == 0 && precision == 0) digitCount = 0;
+
+			size_t zeros = (precision > digitCount) ? precision - digitCount : 0;
+			size_t length = (value < 0) + zeros + digitCount;
+
+			char* pNext = PadLeft (pDst, length, width, leftJustified);
+			if (value < 0) *pNext++ = '-';
+			std::memset (pNext, '0', zeros);
+			std::memcpy (pNext + zeros, digits, digitCount);
+			pNext += zeros + digitCount;
+
+			return static_cast<size_t>(PadRight (pNext, length, width, leftJustified) - pDst);
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// As "%W.Pf"
+
+		static size_t FormatFloat (char* pDst, double value, uint8_t width, uint8_t precision, bool leftJustified) noexcept
+		{
+			char digits[MaximumFieldSize];
+			std::to_chars_result result = std::to_chars (digits, digits + sizeof (digits), value, std::chars_format::fixed, precision);
+			size_t length = (result.ec == std::errc ()) ? static_cast<size_t>(result.ptr - digits) : 0;
+
+			char* pNext = PadLeft (pDst, length, width, leftJustified);
+			std::memcpy (pNext, digits, length);
+			pNext += length;
+
+			return static_cast<size_t>(PadRight (pNext, length, width, leftJustified) - pDst);
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// As "%.Ws", the width is the maximum number of characters kept
+
+		static std::string_view FormatString (std::string_view text, uint8_t width) noexcept
+		{
+			return text.substr (0, std::min (text.find ('\0'), static_cast<size_t>(width)));
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Parses a whole field in place with std::from_chars, which ignores
+		/// the locale and never throws. Leading and trailing blanks are ignored
+		/// and anything else left over fails the conversion. Text types take
+		/// the field as it is.
+
+		template <typename T>
+		[[nodiscard]] static CSVResult<T> ParseValue (std::string_view text) noexcept
+		{
+			if constexpr (std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>)
+			{
+				return T (text);
+			}
+			else
+			{
+				static_assert (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Only numeric and text fields can be parsed");
+
+				T value {};
+
+				text = Trim (text);
+				if (text.empty ()) return CSVParseError::Empty;
+
+				std::from_chars_result result = std::from_chars (text.data (), text.data () + text.length (), value);
+				if (result.ec == std::errc::result_out_of_range) return CSVParseError::OutOfRange;
+				if (result.ec != std::errc ()) return CSVParseError::Invalid;
+				if (result.ptr != text.data () + text.length ()) return CSVParseError::Trailing;
+
+				return value;
+			}
+		}
+
+		template <typename T>
+		[[nodiscard]] static bool Parse (std::string_view text, T& value) noexcept
+		{
+			CSVResult<T> result = ParseValue<T> (text);
+			if (result) value = *result;
+			return result.HasValue ();
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Parses the leading fields of a row into a tuple in one pass,
+		/// stopping at the first field that fails. Extra fields are ignored.
+
+		template <typename... Types>
+		[[nodiscard]] static CSVRowStatus ParseRow (std::span<const std::string_view> fields, std::tuple<Types...>& values) noexcept
+		{
+			CSVRowStatus status {CSVParseError::None, 0};
+
+			if (fields.size () < sizeof... (Types)) return {CSVParseError::MissingField, fields.size ()};
+
+			ParseFields (fields, values, status, std::index_sequence_for<Types...> ());
+			return status;
+		}
+
+		[[nodiscard]] static std::string_view Trim (std::string_view text) noexcept
+		{
+			size_t first = text.find_first_not_of (Blanks);
+			if (first == std::string_view::npos) return {};
+			return text.substr (first, text.find_last_not_of (Blanks) - first + 1);
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Parses a date written by Clock::GetASCIIDate, "YYYY/MM/DD" with any
+		/// single character separator
+
+		[[nodiscard]] static bool ParseDate (std::string_view text, int& year, int& month, int& day) noexcept
+		{
+			text = Trim (text);
+			if (text.length () != 10) return false;
+
+			return ParseDigits (text.substr (0, 4), year) && ParseDigits (text.substr (5, 2), month) && ParseDigits (text.substr (8, 2), day) &&
+				month >= 1 && month <= 12 && day >= 1 && day <= 31;
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Parses a time written by Clock::GetASCIITime, "HH:MM:SS", any
+		/// fraction of a second after it is ignored
+
+		[[nodiscard]] static bool ParseTime (std::string_view text, int& hours, int& minutes, int& seconds) noexcept
+		{
+			int fraction = 0;
+
+			text = Trim (text);
+			if (text.length () > 9 && text[8] == '.' && ParseDigits (text.substr (9, 9), fraction)) text = text.substr (0, 8);
+			if (text.length () != 8 || text[2] != ':' || text[5] != ':') return false;
+
+			return ParseDigits (text.substr (0, 2), hours) && ParseDigits (text.substr (3, 2), minutes) && ParseDigits (text.substr (6, 2), seconds) &&
+				hours < 24 && minutes < 60 && seconds < 61;
+		}
+
+	private:
+
+		static constexpr std::string_view Blanks = " \t";
+
+		template <typename Tuple, size_t... Index>
+		static void ParseFields (std::span<const std::string_view> fields, Tuple& values, CSVRowStatus& status, std::index_sequence<Index...>) noexcept
+		{
+			(ParseField (fields[Index], std::get<Index> (values), Index, status) && ...);
+		}
+
+		template <typename T>
+		static bool ParseField (std::string_view text, T& value, size_t column, CSVRowStatus& status) noexcept
+		{
+			CSVResult<T> result = ParseValue<T> (text);
+
+			if (!result)
+			{
+				status = {result.GetError (), column};
+				return false;
+			}
+
+			value = *result;
+			return true;
+		}
+
+		static bool ParseDigits (std::string_view text, int& value) noexcept
+		{
+			value = 0;
+
+			for (char digit : text)
+			{
+				if (digit < '0' || digit > '9') return false;
+				value = (value * 10) + (digit - '0');
+			}
+
+			return true;
+		}
+
+		static char* PadLeft (char* pDst, size_t length, uint8_t width, bool leftJustified) noexcept
+		{
+			if (leftJustified || length >= width) return pDst;
+			std::memset (pDst, ' ', width - length);
+			return pDst + (width - length);
+		}
+
+		static char* PadRight (char* pDst, size_t length, uint8_t width, bool leftJustified) noexcept
+		{
+			if (!leftJustified || length >= width) return pDst;
+			std::memset (pDst, ' ', width - length);
+			return pDst + (width - length);
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Date and Time column text for a row time. Logged rows mostly share the
+	/// same second, so localtime and the formatting are only redone when the
+	/// second changes and the date only when the day changes. Otherwise the
+	/// cached text is copied.
+	/// </summary>
+
+	class CSVTimestamp
+	{
+	public:
+
+		static constexpr size_t DateSize = sizeof ("YYYY/MM/DD") - 1;
+		static constexpr size_t TimeSize = sizeof ("HH:MM:SS") - 1;
+		static constexpr uint8_t MaximumPrecision = 9;
+		static constexpr size_t MaximumTimeSize = TimeSize + 1 + MaximumPrecision;
+
+		CSVTimestamp () noexcept : m_second (-1), m_nanoseconds (0), m_year (-1), m_yearDay (-1) {}
+
+		void Update (const timespec& time) noexcept
+		{
+			m_nanoseconds = static_cast<uint32_t>(time.tv_nsec);
+			if (time.tv_sec == m_second) return;
+
+			tm localTime {};
+			m_second = time.tv_sec;
+			localtime_r (&m_second, &localTime);
+
+			WriteDigits (m_time, localTime.tm_hour, 2);
+			WriteDigits (m_time + 3, localTime.tm_min, 2);
+			WriteDigits (m_time + 6, localTime.tm_sec, 2);
+			m_time[2] = m_time[5] = ':';
+
+			if (localTime.tm_yday != m_yearDay || localTime.tm_year != m_year)
+			{
+				WriteDigits (m_date, localTime.tm_year + 1900, 4);
+				WriteDigits (m_date + 5, localTime.tm_mon + 1, 2);
+				WriteDigits (m_date + 8, localTime.tm_mday, 2);
+				m_date[4] = m_date[7] = '/';
+
+				m_year = localTime.tm_year;
+				m_yearDay = localTime.tm_yday;
+			}
+		}
+
+		[[nodiscard]] std::string_view GetDate () const noexcept { return {m_date, DateSize}; }
+		[[nodiscard]] std::string_view GetTime () const noexcept { return {m_time, TimeSize}; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Time with the given number of decimal places on the seconds, so 3
+		/// for milliseconds and 6 for microseconds. Writes up to
+		/// MaximumTimeSize characters and returns the number written.
+
+		size_t FormatTime (char* pDst, uint8_t precision) const noexcept
+		{
+			std::memcpy (pDst, m_time, TimeSize);
+
+			precision = std::min (precision, MaximumPrecision);
+			if (precision == 0) return TimeSize;
+
+			uint32_t fraction = m_nanoseconds;
+			for (uint8_t digit = precision; digit < MaximumPrecision; ++digit) fraction /= 10;
+
+			pDst[TimeSize] = '.';
+			WriteDigits (pDst + TimeSize + 1, static_cast<int>(fraction), precision);
+			return TimeSize + 1 + precision;
+		}
+
+	private:
+
+		static void WriteDigits (char* pDst, int value, size_t digits) noexcept
+		{
+			for (size_t index = digits; index > 0; --index)
+			{
+				pDst[index - 1] = static_cast<char>('0' + (value % 10));
+				value /= 10;
+			}
+		}
+
+		time_t		m_second;
+		uint32_t	m_nanoseconds;
+		int			m_year;
+		int			m_yearDay;
+		char		m_date[DateSize] {};
+		char		m_time[TimeSize] {};
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Converts Date and Time columns to local time_t values. Logged rows share
+	/// the same date and hour for long runs, so mktime is only called when
+	/// either changes.
+	/// </summary>
+
+	class CSVTimeParser
+	{
+	public:
+
+		CSVTimeParser () noexcept : m_dateBase (-1), m_hourBase (-1), m_hour (-1) {}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Local midnight at the start of the date
+
+		[[nodiscard]] bool ParseDate (std::string_view date, time_t& value) noexcept
+		{
+			date = CSVFormat::Trim (date);
+
+			if (date != std::string_view (m_dateText, sizeof (m_dateText)) || m_dateBase < 0)
+			{
+				m_hour = -1;
+				if (!MakeTime (date, 0, m_dateBase)) return false;
+				std::memcpy (m_dateText, date.data (), sizeof (m_dateText));
+			}
+
+			value = m_dateBase;
+			return true;
+		}
+
+		////////////////////////////////////////////////////////////////////////
+		/// Seconds since midnight
+
+		[[nodiscard]] static bool ParseTimeOfDay (std::string_view time, time_t& value) noexcept
+		{
+			int hours, minutes, seconds;
+			if (!CSVFormat::ParseTime (time, hours, minutes, seconds)) return false;
+
+			value = (hours * 3600) + (minutes * 60) + seconds;
+			return true;
+		}
+
+		[[nodiscard]] bool ParseTimestamp (std::string_view date, std::string_view time, time_t& value) noexcept
+		{
+			time_t midnight;
+			int hours, minutes, seconds;
+
+			if (!ParseDate (date, midnight) || !CSVFormat::ParseTime (time, hours, minutes, seconds)) return false;
+
+			// The hour is converted separately so daylight saving changes are honoured
+			if (hours != m_hour)
+			{
+				if (!MakeTime (CSVFormat::Trim (date), hours, m_hourBase)) return false;
+				m_hour = hours;
+			}
+
+			value = m_hourBase + (minutes * 60) + seconds;
+			return true;
+		}
+
+	private:
+
+		static bool MakeTime (std::string_view date, int hours, time_t& value) noexcept
+		{
+			tm localTime {};
+
+			if (!CSVFormat::ParseDate (date, localTime.tm_year, localTime.tm_mon, localTime.tm_mday)) return false;
+
+			localTime.tm_year -= 1900;
+			localTime.tm_mon -= 1;
+			localTime.tm_hour = hours;
+			localTime.tm_isdst = -1;
+
+			value = mktime (&localTime);
+			return value != -1;
+		}
+
+		char	m_dateText[10] {};
+		time_t	m_dateBase;
+		time_t	m_hourBase;
+		int		m_hour;
+	};
+}
+
+#endif
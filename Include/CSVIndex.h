@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_INDEX_H_
+#define _CSV_INDEX_H_
+
+#include "FileObject.h"
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Sidecar index for a CSV file, kept alongside it with an ".idx" suffix.
+	/// The file is a Header followed by one Entry for every Nth row giving the
+	/// byte offset of the start of the row and its timestamp. Rows count every
+	/// non empty line from the start of the file, so with a header line the
+	/// first row of data is row 1.
+	/// </summary>
+
+	class CSVIndex
+	{
+	public:
+
+		struct Header
+		{
+			char		m_magic[8];
+			uint32_t	m_version;
+			uint32_t	m_entrySize;
+		};
+
+		struct Entry
+		{
+			uint64_t	m_row;
+			int64_t		m_offset;
+			int64_t		m_time;
+		};
+
+		static_assert (sizeof (Header) == 16);
+		static_assert (sizeof (Entry) == 24);
+
+		static constexpr const char Magic[8] = {'S', 'P', 'C', 'C', 'S', 'V', 'X', '1'};
+		static constexpr uint32_t Version = 1;
+		static constexpr uint32_t DefaultInterval = 1024;
+
+		CSVIndex () noexcept = default;
+		virtual ~CSVIndex () noexcept = default;
+
+		CSVIndex (const CSVIndex& from) = delete;
+		CSVIndex (CSVIndex&& from) = delete;
+		CSVIndex& operator = (const CSVIndex& from) = delete;
+		CSVIndex& operator = (CSVIndex&& from) = delete;
+
+		[[nodiscard]] static std::string GetIndexPath (const std::string& filePath) { return filePath + ".idx"; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Loads the index for a CSV file, entries past the end of the file
+		/// are dropped. Returns false quietly if there is no index.
+
+		[[nodiscard]] bool Load (const std::string& filePath, off_t fileSize) noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Loads the index and keeps it open to add entries to. An index that
+		/// does not match the file is written again from the entries that do.
+
+		[[nodiscard]] bool OpenForWriting (const std::string& filePath, off_t fileSize) noexcept;
+		[[nodiscard]] bool Append (const Entry& entry) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] bool IsEmpty () const noexcept { return m_entries.empty (); }
+		[[nodiscard]] const std::vector<Entry>& GetEntries () const noexcept { return m_entries; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// The last entry at or before the row, or before the time. Returns
+		/// nullptr if reading has to start from the beginning of the file.
+
+		[[nodiscard]] const Entry* FindRow (uint64_t row) const noexcept;
+		[[nodiscard]] const Entry* FindTime (time_t time) const noexcept;
+
+	private:
+
+		[[nodiscard]] bool LoadEntries (const std::string& filePath, off_t fileSize, bool& complete) noexcept;
+		[[nodiscard]] bool Rewrite (const std::string& indexPath) noexcept;
+
+		FileObject			m_fileObject;
+		std::vector<Entry>	m_entries;
+	};
+}
+
+#endif
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_MERGER_H_
+#define _CSV_MERGER_H_
+
+#include "CSVCore.h"
+#include "CSVFile.h"
+#include "CSVFormat.h"
+#include "FileObject.h"
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Merges CSV files that are each in Date and Time order into one stream
+	/// in time order without loading them. Every input is mapped and read a
+	/// row at a time through its own CSVReader, and a heap holding the next
+	/// row of each input picks the earliest, so merging N files of M rows
+	/// costs M log N comparisons and memory for N rows. Rows with the same
+	/// time keep the order the inputs were added in, fractions of a second
+	/// written by CSVTimestamp are taken into account.
+	///
+	/// The column collection gives the layout shared by all the inputs and
+	/// must have a Date and a Time column. Rows without a valid time are
+	/// skipped.
+	/// </summary>
+
+	class CSVMerger
+	{
+	public:
+
+		static constexpr size_t WriteBufferSize = 64 * 1024;
+
+		CSVMerger (CSVColumnCollection& columnCollection) noexcept;
+		virtual ~CSVMerger () = default;
+
+		CSVMerger (const CSVMerger& from) = delete;
+		CSVMerger (CSVMerger&& from) = delete;
+		CSVMerger& operator = (const CSVMerger& from) = delete;
+		CSVMerger& operator = (CSVMerger&& from) = delete;
+
+		[[nodiscard]] bool AddInput (const std::string& filePath, bool hasHeader = true) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] size_t GetInputCount () const noexcept { return m_inputs.size (); }
+		[[nodiscard]] uint64_t GetSkippedRows () const noexcept { return m_skippedRows; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Calls the handler for every row in time order with the reader of
+		/// the input it came from, the fields are available through GetField.
+		/// The handler returns false to stop early. Inputs are read through
+		/// once, so merging again needs Close and the inputs added again.
+
+		using RowHandler = std::function<bool (const CSVReader& reader, size_t input, time_t rowTime)>;
+
+		[[nodiscard]] bool Merge (const RowHandler& handler) noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Writes the merged rows to a new file, with the first input's header
+		/// when the inputs have one
+
+		[[nodiscard]] bool Merge (const std::string& filePath) noexcept;
+
+	private:
+
+		struct Input
+		{
+			std::unique_ptr<CSVColumnCollection>	pColumnCollection;
+			std::unique_ptr<CSVReader>				pReader;
+			CSVTimeParser							timeParser;
+			time_t									rowTime = 0;
+			uint32_t								rowNanoseconds = 0;
+			bool									readValid = false;
+		};
+
+		struct HeapEntry
+		{
+			time_t		rowTime;
+			uint32_t	rowNanoseconds;
+			size_t		input;
+
+			// Reversed so the standard heap functions keep the earliest row on top
+			[[nodiscard]] bool operator < (const HeapEntry& other) const noexcept
+			{
+				if (rowTime != other.rowTime) return rowTime > other.rowTime;
+				if (rowNanoseconds != other.rowNanoseconds) return rowNanoseconds > other.rowNanoseconds;
+				return input > other.input;
+			}
+		};
+
+		[[nodiscard]] bool FindTimeColumns () noexcept;
+		[[nodiscard]] bool NextRow (Input& input) noexcept;
+		[[nodiscard]] static uint32_t ParseNanoseconds (std::string_view time) noexcept;
+		[[nodiscard]] bool WriteRow (ASCIIFileObject& fileObject, const CSVReader& reader) noexcept;
+		[[nodiscard]] bool WriteHeader (ASCIIFileObject& fileObject) noexcept;
+
+		CSVColumnCollection&	m_columnCollection;
+		std::vector<Input>		m_inputs;
+		std::string				m_lineText;
+		uint64_t				m_skippedRows;
+		uint32_t				m_dateColumn;
+		uint32_t				m_timeColumn;
+		bool					m_hasHeader;
+	};
+}
+
+#endif
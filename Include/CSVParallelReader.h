@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_PARALLEL_READER_H_
+#define _CSV_PARALLEL_READER_H_
+
+#include "CSVCore.h"
+#include "CSVFormat.h"
+#include "MappedFile.h"
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// The rows parsed from one byte range of a file. Every row has one field
+	/// per column of the collection, missing fields are empty and extra fields
+	/// are dropped. Fields are views into the reader's mapping and remain
+	/// valid until the reader is closed.
+	/// </summary>
+
+	class CSVChunk
+	{
+	public:
+
+		CSVChunk () noexcept : m_index (0), m_offset (0), m_columns (0), m_rowCount (0) {}
+		virtual ~CSVChunk () = default;
+
+		CSVChunk (const CSVChunk& from) = default;
+		CSVChunk (CSVChunk&& from) = default;
+		CSVChunk& operator = (const CSVChunk& from) = default;
+		CSVChunk& operator = (CSVChunk&& from) = default;
+
+		[[nodiscard]] uint32_t GetIndex () const noexcept { return m_index; }
+		[[nodiscard]] size_t GetOffset () const noexcept { return m_offset; }
+		[[nodiscard]] size_t GetColumns () const noexcept { return m_columns; }
+		[[nodiscard]] size_t GetRowCount () const noexcept { return m_rowCount; }
+
+		[[nodiscard]] std::string_view GetField (size_t row, size_t column) const noexcept
+		{
+			return (row < m_rowCount && column < m_columns) ? m_fields[row * m_columns + column] : std::string_view ();
+		}
+
+		template <typename T>
+		[[nodiscard]] bool GetFieldAs (size_t row, size_t column, T& value) const noexcept
+		{
+			return CSVFormat::Parse (GetField (row, column), value);
+		}
+
+		template <typename T>
+		[[nodiscard]] CSVResult<T> GetFieldAs (size_t row, size_t column) const noexcept
+		{
+			if (row >= m_rowCount || column >= m_columns) return CSVParseError::MissingField;
+			return CSVFormat::ParseValue<T> (m_fields[row * m_columns + column]);
+		}
+
+		template <typename... Types>
+		[[nodiscard]] CSVRowStatus GetRowAs (size_t row, std::tuple<Types...>& values) const noexcept
+		{
+			if (row >= m_rowCount) return {CSVParseError::MissingField, 0};
+			return CSVFormat::ParseRow (std::span<const std::string_view> (m_fields.data () + row * m_columns, m_columns), values);
+		}
+
+	private:
+
+		friend class CSVParallelReader;
+
+		void Parse (std::string_view text, size_t columns, std::vector<uint32_t>& delimiters);
+
+		uint32_t						m_index;
+		size_t							m_offset;
+		size_t							m_columns;
+		size_t							m_rowCount;
+		std::vector<std::string_view>	m_fields;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Loads a mapped CSV file on several threads. The file is split into byte
+	/// ranges that end on a line feed and each range is parsed independently.
+	/// The column count and types come from the collection.
+	/// </summary>
+
+	class CSVParallelReader
+	{
+	public:
+
+		using ChunkConsumer = std::function<void (const CSVChunk& chunk)>;
+
+		static constexpr size_t MinimumChunkSize = 1024 * 1024;
+		static constexpr size_t MaximumChunkSize = 256 * 1024 * 1024;
+		static constexpr uint32_t ChunksPerThread = 4;
+
+		CSVParallelReader (CSVColumnCollection& columnCollection) noexcept;
+		virtual ~CSVParallelReader () = default;
+
+		CSVParallelReader (const CSVParallelReader& from) = delete;
+		CSVParallelReader (CSVParallelReader&& from) = delete;
+		CSVParallelReader& operator = (const CSVParallelReader& from) = delete;
+		CSVParallelReader& operator = (CSVParallelReader&& from) = delete;
+
+		[[nodiscard]] bool Open (const std::string& filePath, bool hasHeader = true) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] size_t GetColumns () noexcept { return m_columnCollection.Columns (); }
+		[[nodiscard]] CSVColumn::Type GetType (uint8_t column) noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Parses every chunk and returns them in file order
+
+		[[nodiscard]] bool Load (std::vector<CSVChunk>& chunks, uint32_t threadCount = 0) noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Hands each chunk to the consumer as soon as it is parsed. The consumer
+		/// is called concurrently from the worker threads in no particular
+		/// order, the chunk index gives its position in the file.
+
+		[[nodiscard]] bool Load (const ChunkConsumer& consumer, uint32_t threadCount = 0) noexcept;
+
+	private:
+
+		[[nodiscard]] bool SplitChunks (uint32_t threadCount) noexcept;
+		void ParseChunk (uint32_t index, CSVChunk& chunk);
+		[[nodiscard]] bool RunWorkers (uint32_t threadCount, const std::function<void (uint32_t index)>& work) noexcept;
+
+		CSVColumnCollection&	m_columnCollection;
+		MappedFile				m_mappedFile;
+		size_t					m_dataOffset;
+		std::vector<size_t>		m_boundaries;
+	};
+}
+
+#endif
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_ROLLUP_WRITER_H_
+#define _CSV_ROLLUP_WRITER_H_
+
+#include "CSVCore.h"
+#include "CSVFile.h"
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	enum class CSVRollup : uint8_t {Minimum, Maximum, Mean, Last};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Writes a downsampled copy of a full rate CSV. Each Add takes the values
+	/// formatted into the column collection shared with the full rate writer,
+	/// so it is called before that writer's WriteLine clears them, or left to
+	/// the writer with CSVWriter::SetRollupWriter. Every period of N seconds
+	/// or N rows one row of rollups is written to a second file. Only the
+	/// running rollups are held in memory.
+	///
+	/// Row, Date and Time columns are copied, the Date and Time giving the
+	/// start of the period. Every other column becomes one output column per
+	/// rollup named with a suffix, "Temp_min", "Temp_max" and "Temp_mean",
+	/// with Last keeping the name. Without any AddRollup calls Int and Float
+	/// columns get their Mean and String columns their Last value.
+	/// </summary>
+
+	class CSVRollupWriter
+	{
+	public:
+
+		static constexpr uint32_t DefaultPeriodSeconds = 60;
+
+		CSVRollupWriter (CSVColumnCollection& columnCollection);
+		virtual ~CSVRollupWriter ();
+
+		CSVRollupWriter (const CSVRollupWriter& from) = delete;
+		CSVRollupWriter (CSVRollupWriter&& from) = delete;
+		CSVRollupWriter& operator = (const CSVRollupWriter& from) = delete;
+		CSVRollupWriter& operator = (CSVRollupWriter&& from) = delete;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Set before Open. Periods in seconds are aligned to whole multiples
+		/// of the period, a row count period starts with its first row. Both
+		/// can be set and whichever ends first closes the period.
+
+		[[nodiscard]] bool AddRollup (uint32_t column, CSVRollup rollup) noexcept;
+		void SetPeriod (uint32_t periodSeconds) noexcept { m_periodSeconds = periodSeconds; }
+		void SetPeriodRows (uint32_t periodRows) noexcept { m_periodRows = periodRows; }
+
+		[[nodiscard]] bool Open (const std::string& filePath, bool append = false) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] bool Add () noexcept;
+		[[nodiscard]] bool Add (const timespec& rowTime) noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Writes out the period so far without waiting for it to end
+
+		[[nodiscard]] bool Flush () noexcept;
+
+		[[nodiscard]] uint64_t GetRowsWritten () const noexcept { return m_rowsWritten; }
+
+	private:
+
+		struct Rollup
+		{
+			uint32_t	column = 0;
+			uint32_t	outputColumn = 0;
+			CSVRollup	rollup = CSVRollup::Mean;
+			double		minimum = 0.0;
+			double		maximum = 0.0;
+			double		sum = 0.0;
+			uint64_t	count = 0;
+			std::string	lastText;
+		};
+
+		[[nodiscard]] bool WriteRollups () noexcept;
+		void AddOutputColumns ();
+
+		CSVColumnCollection&	m_columnCollection;
+		CSVColumnCollection		m_rollupCollection;
+		CSVWriter				m_writer;
+		std::vector<Rollup>		m_rollups;
+		time_t					m_periodStart;
+		uint32_t				m_periodSeconds;
+		uint32_t				m_periodRows;
+		uint32_t				m_rowCount;
+		uint64_t				m_rowsWritten;
+	};
+}
+
+#endif
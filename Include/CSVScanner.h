@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_SCANNER_H_
+#define _CSV_SCANNER_H_
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Vectorised search for the comma, carriage return and line feed
+	/// characters that delimit CSV fields and lines. The text is examined in
+	/// 64 byte blocks using AVX2 or SSE2 on x86 and NEON on ARM, with a scalar
+	/// fallback for other targets.
+	/// </summary>
+
+	class CSVScanner
+	{
+	public:
+
+		static constexpr size_t BlockSize = 64;
+
+		CSVScanner () = delete;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Appends the offset of every delimiter in the text to the offsets and
+		/// returns how many were found. The text must be shorter than 4GiB.
+
+		static size_t FindDelimiters (std::string_view text, std::vector<uint32_t>& offsets) noexcept;
+
+		[[nodiscard]] static const char* GetImplementation () noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,260 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_SCHEMA_H_
+#define _CSV_SCHEMA_H_
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "CSVCore.h"
+#include "CSVFormat.h"
+#include "FileObject.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Column name usable as a template argument
+	/// </summary>
+
+	template <size_t Length>
+	struct CSVName
+	{
+		constexpr CSVName (const char (&name)[Length]) noexcept { std::copy_n (name, Length, m_text); }
+		constexpr std::string_view View () const noexcept { return {m_text, Length - 1}; }
+
+		char m_text[Length];
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Compile time equivalent of a CSVColumn
+	/// </summary>
+
+	template <CSVColumn::Type ColumnType, CSVName Name, uint8_t Width = 0, uint8_t Precision = 0, bool LeftJustified = false>
+	struct CSVField
+	{
+		static constexpr CSVColumn::Type Type = ColumnType;
+		static constexpr std::string_view ColumnName = Name.View ();
+		static constexpr uint8_t FieldWidth = Width;
+		static constexpr uint8_t FieldPrecision = Precision;
+		static constexpr bool FieldLeftJustified = LeftJustified;
+		static constexpr bool IsFixed = (Type == CSVColumn::Type::Row || Type == CSVColumn::Type::Date || Type == CSVColumn::Type::Time);
+
+		// Largest output for the type: sign, digits, point and precision, or the padded width
+		static constexpr size_t MaximumSize = (Type == CSVColumn::Type::Date) ? sizeof ("YYYY/MM/DD") - 1 :
+			(Type == CSVColumn::Type::Time) ? CSVTimestamp::TimeSize + (Precision ? 1 + std::min (Precision, CSVTimestamp::MaximumPrecision) : 0) :
+			(Type == CSVColumn::Type::String) ? Width :
+			(Type == CSVColumn::Type::Float) ? std::max<size_t> (Width, 41 + Precision) :
+			std::max<size_t> (Width, 21 + Precision);
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Fixed set of typed columns. Row, Date and Time columns are filled in
+	/// automatically, every other column takes one value per row in order.
+	/// </summary>
+
+	template <typename... Fields>
+	class CSVSchema
+	{
+	public:
+
+		static constexpr std::string_view Separator = ", ";
+		static constexpr std::string_view NewLine = "\r\n";
+
+		static constexpr size_t Columns = sizeof... (Fields);
+		static constexpr size_t ValueCount = ((Fields::IsFixed ? 0 : 1) + ... + 0);
+		static constexpr bool HasClock = ((Fields::Type == CSVColumn::Type::Date || Fields::Type == CSVColumn::Type::Time) || ... || false);
+		static constexpr size_t MaximumRowSize = (Fields::MaximumSize + ... + 0) + (Columns * Separator.length ()) + NewLine.length ();
+		static constexpr size_t MaximumHeaderSize = (Fields::ColumnName.length () + ... + 0) + (Columns * Separator.length ()) + NewLine.length ();
+
+		static_assert (Columns > 0, "A schema needs at least one column");
+
+		CSVSchema () = delete;
+
+		template <typename Tuple>
+		static size_t FormatRow (char* pDst, uint32_t rowNumber, const CSVTimestamp& timestamp, const Tuple& values) noexcept
+		{
+			char* pNext = pDst;
+			FormatColumns (pNext, rowNumber, timestamp, values, std::make_index_sequence<Columns> ());
+			pNext = Append (pNext, NewLine);
+			return static_cast<size_t>(pNext - pDst);
+		}
+
+		static size_t FormatHeader (char* pDst) noexcept
+		{
+			char* pNext = pDst;
+			size_t index = 0;
+			((pNext = Append ((index++ != 0) ? Append (pNext, Separator) : pNext, Fields::ColumnName)), ...);
+			return static_cast<size_t>(Append (pNext, NewLine) - pDst);
+		}
+
+	private:
+
+		static constexpr std::array<bool, Columns> Fixed = {Fields::IsFixed...};
+
+		template <size_t Index>
+		using FieldAt = std::tuple_element_t<Index, std::tuple<Fields...>>;
+
+		template <size_t Index>
+		static constexpr size_t ValueIndex () noexcept
+		{
+			size_t valueIndex = 0;
+			for (size_t column = 0; column < Index; ++column) if (!Fixed[column]) ++valueIndex;
+			return valueIndex;
+		}
+
+		static char* Append (char* pDst, std::string_view text) noexcept
+		{
+			std::memcpy (pDst, text.data (), text.length ());
+			return pDst + text.length ();
+		}
+
+		template <typename Tuple, size_t... Index>
+		static void FormatColumns (char*& pNext, uint32_t rowNumber, const CSVTimestamp& timestamp, const Tuple& values, std::index_sequence<Index...>) noexcept
+		{
+			((pNext = FormatColumn<Index> (pNext, rowNumber, timestamp, values)), ...);
+		}
+
+		template <size_t Index, typename Tuple>
+		static char* FormatColumn (char* pNext, uint32_t rowNumber, const CSVTimestamp& timestamp, const Tuple& values) noexcept
+		{
+			using Field = FieldAt<Index>;
+
+			if constexpr (Index != 0) pNext = Append (pNext, Separator);
+
+			if constexpr (Field::Type == CSVColumn::Type::Row)
+			{
+				return pNext + CSVFormat::FormatInteger (pNext, rowNumber, Field::FieldWidth, Field::FieldPrecision, Field::FieldLeftJustified);
+			}
+			else if constexpr (Field::Type == CSVColumn::Type::Date)
+			{
+				return Append (pNext, timestamp.GetDate ());
+			}
+			else if constexpr (Field::Type == CSVColumn::Type::Time)
+			{
+				return pNext + timestamp.FormatTime (pNext, Field::FieldPrecision);
+			}
+			else
+			{
+				const auto& value = std::get<ValueIndex<Index> ()> (values);
+				using Value = std::decay_t<decltype (value)>;
+
+				if constexpr (Field::Type == CSVColumn::Type::String)
+				{
+					static_assert (std::is_convertible_v<const Value&, std::string_view>, "String column needs text");
+					return Append (pNext, CSVFormat::FormatString (value, Field::FieldWidth));
+				}
+				else if constexpr (Field::Type == CSVColumn::Type::Float)
+				{
+					static_assert (std::is_arithmetic_v<Value>, "Float column needs a number");
+					return pNext + CSVFormat::FormatFloat (pNext, static_cast<float>(value), Field::FieldWidth, Field::FieldPrecision, Field::FieldLeftJustified);
+				}
+				else
+				{
+					static_assert (std::is_integral_v<Value>, "Int column needs an integer");
+
+					// Matches CSVColumn, which writes a zero without padding
+					if (value == 0) return Append (pNext, "0");
+					return pNext + CSVFormat::FormatInteger (pNext, static_cast<int32_t>(value), Field::FieldWidth, Field::FieldPrecision, Field::FieldLeftJustified);
+				}
+			}
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Typed writer for a CSVSchema, each row is formatted into one buffer
+	/// and written with a single call
+	/// </summary>
+
+	template <typename Schema>
+	class CSVSchemaWriter
+	{
+	public:
+
+		CSVSchemaWriter () noexcept : m_rowNumber (0) {}
+		virtual ~CSVSchemaWriter () = default;
+
+		CSVSchemaWriter (const CSVSchemaWriter& from) = delete;
+		CSVSchemaWriter (CSVSchemaWriter&& from) = delete;
+		CSVSchemaWriter& operator = (const CSVSchemaWriter& from) = delete;
+		CSVSchemaWriter& operator = (CSVSchemaWriter&& from) = delete;
+
+		[[nodiscard]] bool Open (const std::string& filePath, bool append = true) noexcept
+		{
+			m_rowNumber = 0;
+
+			if (append && m_fileObject.Open (filePath, true)) return true;
+			return m_fileObject.Create (filePath);
+		}
+
+		void Close () noexcept { m_fileObject.Close (); }
+		[[nodiscard]] bool Flush () noexcept { return m_fileObject.Flush (); }
+
+		void SetWriteBuffer (size_t bufferSize, uint32_t flushIntervalms = 0) noexcept
+		{
+			m_fileObject.SetWriteBuffer (bufferSize, flushIntervalms);
+		}
+
+		[[nodiscard]] bool WriteHeader () noexcept
+		{
+			char header[Schema::MaximumHeaderSize];
+			return m_fileObject.Write (reinterpret_cast<const uint8_t*>(header), Schema::FormatHeader (header));
+		}
+
+		template <typename... Values>
+		[[nodiscard]] bool Write (const Values&... values) noexcept
+		{
+			static_assert (sizeof... (Values) == Schema::ValueCount, "One value is needed for each non fixed column");
+
+			if constexpr (Schema::HasClock)
+			{
+				timespec now {};
+				clock_gettime (CLOCK_REALTIME, &now);
+				m_timestamp.Update (now);
+			}
+
+			size_t length = Schema::FormatRow (m_rowBuffer, ++m_rowNumber, m_timestamp, std::forward_as_tuple (values...));
+			return m_fileObject.Write (reinterpret_cast<const uint8_t*>(m_rowBuffer), length);
+		}
+
+	private:
+
+		ASCIIFileObject	m_fileObject;
+		uint32_t		m_rowNumber;
+		CSVTimestamp	m_timestamp;
+		char			m_rowBuffer[Schema::MaximumRowSize];
+	};
+}
+
+#endif
@@ -0,0 +1,176 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_STATISTICS_H_
+#define _CSV_STATISTICS_H_
+
+#include "CSVCore.h"
+#include "CSVFormat.h"
+
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	class CSVReader;
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Single pass summary of one numeric column. The mean and variance are
+	/// kept with Welford's method so they stay accurate over long files, and
+	/// percentiles come from a log scaled histogram with 64 buckets per power
+	/// of two, which keeps them within about 1% of the true value in a few
+	/// kilobytes whatever the number of values.
+	/// </summary>
+
+	class CSVColumnStatistics
+	{
+	public:
+
+		CSVColumnStatistics () noexcept : m_count (0), m_minimum (NAN), m_maximum (NAN), m_mean (0.0), m_squares (0.0) {}
+		virtual ~CSVColumnStatistics () = default;
+
+		CSVColumnStatistics (const CSVColumnStatistics& from) = default;
+		CSVColumnStatistics (CSVColumnStatistics&& from) = default;
+		CSVColumnStatistics& operator = (const CSVColumnStatistics& from) = default;
+		CSVColumnStatistics& operator = (CSVColumnStatistics&& from) = default;
+
+		void Add (double value);
+		void Merge (const CSVColumnStatistics& from);
+		void Clear () noexcept;
+
+		[[nodiscard]] uint64_t GetCount () const noexcept { return m_count; }
+		[[nodiscard]] double GetMinimum () const noexcept { return m_minimum; }
+		[[nodiscard]] double GetMaximum () const noexcept { return m_maximum; }
+		[[nodiscard]] double GetMean () const noexcept { return (m_count > 0) ? m_mean : NAN; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Sample variance, so divided by one less than the count
+
+		[[nodiscard]] double GetVariance () const noexcept { return (m_count > 1) ? m_squares / static_cast<double>(m_count - 1) : NAN; }
+		[[nodiscard]] double GetStandardDeviation () const noexcept { return std::sqrt (GetVariance ()); }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Approximate value below which the given percentage of values fall,
+		/// 50 for the median
+
+		[[nodiscard]] double GetPercentile (double percentile) const noexcept;
+
+	private:
+
+		static constexpr int32_t SubBuckets = 64;
+		static constexpr int32_t ExponentBias = 1100;
+		static constexpr double ZeroMagnitude = 1e-300;
+
+		[[nodiscard]] static int32_t GetBucket (double value) noexcept;
+		[[nodiscard]] static double GetBucketValue (int32_t bucket) noexcept;
+
+		uint64_t					m_count;
+		double						m_minimum;
+		double						m_maximum;
+		double						m_mean;
+		double						m_squares;
+		std::map<int32_t, uint64_t>	m_histogram;
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Length of the local time periods rows are grouped by
+	/// </summary>
+
+	enum class CSVTimeBucket : uint32_t {All = 0, Minute = 60, Hour = 3600, Day = 86400};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Streams rows from a CSVReader into a CSVColumnStatistics for each
+	/// numeric column, optionally one set per minute, hour or day taken from
+	/// the Date and Time columns. Only the summaries are kept so memory does
+	/// not grow with the file. Fields that are not numbers are skipped, as
+	/// are rows without a valid time when grouping.
+	/// </summary>
+
+	class CSVStatistics
+	{
+	public:
+
+		using Group = std::vector<CSVColumnStatistics>;
+
+		CSVStatistics (CSVColumnCollection& columnCollection) noexcept;
+		virtual ~CSVStatistics () = default;
+
+		CSVStatistics (const CSVStatistics& from) = delete;
+		CSVStatistics (CSVStatistics&& from) = delete;
+		CSVStatistics& operator = (const CSVStatistics& from) = delete;
+		CSVStatistics& operator = (CSVStatistics&& from) = delete;
+
+		////////////////////////////////////////////////////////////////////////
+		/// By default every Int and Float column of the collection is summed
+		/// up with no grouping. Both clear any statistics gathered so far.
+
+		[[nodiscard]] bool SetColumns (const std::vector<uint32_t>& columns) noexcept;
+		void SetTimeBucket (CSVTimeBucket timeBucket) noexcept;
+		void Clear () noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Add takes the fields of the row last read, Read reads rows until
+		/// the end of the file so any header must already have been read
+
+		[[nodiscard]] bool Add (const CSVReader& reader) noexcept;
+		[[nodiscard]] bool Read (CSVReader& reader) noexcept;
+
+		[[nodiscard]] const std::vector<uint32_t>& GetColumns () const noexcept { return m_columns; }
+		[[nodiscard]] uint64_t GetSkippedRows () const noexcept { return m_skippedRows; }
+
+		////////////////////////////////////////////////////////////////////////
+		/// Groups keyed by the local start time of their period, there is a
+		/// single group keyed by zero when not grouping by time. Each holds
+		/// one entry per column in the order of GetColumns.
+
+		[[nodiscard]] const std::map<time_t, Group>& GetGroups () const noexcept { return m_groups; }
+
+	private:
+
+		void Prepare ();
+		[[nodiscard]] bool GetGroupTime (const CSVReader& reader, time_t& groupTime) noexcept;
+
+		CSVColumnCollection&		m_columnCollection;
+		std::vector<uint32_t>		m_columns;
+		std::map<time_t, Group>		m_groups;
+		Group*						m_pGroup;
+		time_t						m_groupTime;
+		CSVTimeBucket				m_timeBucket;
+		CSVTimeParser				m_timeParser;
+		uint64_t					m_skippedRows;
+		int32_t						m_dateColumn;
+		int32_t						m_timeColumn;
+		bool						m_prepared;
+	};
+}
+
+#endif
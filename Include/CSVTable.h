@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _CSV_TABLE_H_
+#define _CSV_TABLE_H_
+
+#include "CSVCore.h"
+
+#include <cmath>
+#include <ctime>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	class CSVChunk;
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Summary of a numeric column, values that failed to parse are skipped
+	/// </summary>
+
+	struct CSVAggregate
+	{
+		size_t	count = 0;
+		double	sum = 0.0;
+		double	minimum = NAN;
+		double	maximum = NAN;
+
+		[[nodiscard]] double Mean () const noexcept { return (count > 0) ? sum / static_cast<double>(count) : NAN; }
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Column oriented in memory table. Each column is held as one contiguous
+	/// array chosen by its CSVColumn::Type:
+	///
+	///   Float			float, NAN where the text was not a number
+	///   Int, Row		int32_t, zero where the text was not a number
+	///   Date			time_t of local midnight, -1 if invalid
+	///   Time			time_t seconds since midnight, -1 if invalid
+	///   String		text packed end to end
+	///
+	/// When there is a Date and a Time column they are also combined into one
+	/// array of local time_t timestamps.
+	/// </summary>
+
+	class CSVTable
+	{
+	public:
+
+		CSVTable (CSVColumnCollection& columnCollection) noexcept;
+		virtual ~CSVTable () = default;
+
+		CSVTable (const CSVTable& from) = delete;
+		CSVTable (CSVTable&& from) = delete;
+		CSVTable& operator = (const CSVTable& from) = delete;
+		CSVTable& operator = (CSVTable&& from) = delete;
+
+		[[nodiscard]] bool Load (const std::string& filePath, bool hasHeader = true, uint32_t threadCount = 0) noexcept;
+		void Clear () noexcept;
+
+		[[nodiscard]] size_t GetRowCount () const noexcept { return m_rowCount; }
+		[[nodiscard]] size_t GetColumns () const noexcept { return m_columns.size (); }
+		[[nodiscard]] CSVColumn::Type GetType (size_t column) const noexcept;
+
+		[[nodiscard]] std::span<const float> GetFloats (size_t column) const noexcept;
+		[[nodiscard]] std::span<const int32_t> GetIntegers (size_t column) const noexcept;
+		[[nodiscard]] std::span<const time_t> GetTimes (size_t column) const noexcept;
+		[[nodiscard]] std::span<const time_t> GetTimestamps () const noexcept { return m_timestamps; }
+		[[nodiscard]] std::string_view GetText (size_t column, size_t row) const noexcept;
+
+		////////////////////////////////////////////////////////////////////////
+		/// Filters narrow a selection of one byte per row, SelectAll starts
+		/// with every row selected
+
+		void SelectAll (std::vector<uint8_t>& selection) const;
+		void FilterRange (size_t column, double minimum, double maximum, std::vector<uint8_t>& selection) const noexcept;
+		void FilterTime (time_t start, time_t end, std::vector<uint8_t>& selection) const noexcept;
+
+		[[nodiscard]] CSVAggregate Aggregate (size_t column) const noexcept;
+		[[nodiscard]] CSVAggregate Aggregate (size_t column, const std::vector<uint8_t>& selection) const noexcept;
+
+	private:
+
+		struct Column
+		{
+			CSVColumn::Type			type = CSVColumn::Type::String;
+			std::vector<float>		floats;
+			std::vector<int32_t>	integers;
+			std::vector<time_t>		times;
+			std::string				text;
+			std::vector<size_t>		textEnds;
+
+			void Append (Column& from);
+		};
+
+		struct Partial
+		{
+			std::vector<Column>	columns;
+			std::vector<time_t>	timestamps;
+			size_t				rowCount = 0;
+		};
+
+		void Convert (const CSVChunk& chunk, Partial& partial) const;
+		void Append (Partial& partial);
+
+		template <typename T>
+		CSVAggregate AggregateValues (std::span<const T> values, const uint8_t* pSelection) const noexcept;
+
+		CSVColumnCollection&	m_columnCollection;
+		std::vector<Column>		m_columns;
+		std::vector<time_t>		m_timestamps;
+		size_t					m_rowCount;
+		int32_t					m_dateColumn;
+		int32_t					m_timeColumn;
+	};
+}
+
+#endif
@@ -28,13 +28,50 @@
 #include <string>
 #include <cstdint>
 #include <cstring>
+#include <new>
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
 
 namespace spc
 {
-	template <typename T>
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Allocator returning storage aligned to a fixed boundary, as needed for
+	/// O_DIRECT transfers
+	/// </summary>
+
+	template <typename T, size_t Alignment>
+	struct AlignedAllocator
+	{
+		using value_type = T;
+
+		template <typename U>
+		struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+		AlignedAllocator () noexcept = default;
+
+		template <typename U>
+		AlignedAllocator (const AlignedAllocator<U, Alignment>&) noexcept {}
+
+		[[nodiscard]] T* allocate (size_t count)
+		{
+			return static_cast<T*>(::operator new (count * sizeof (T), std::align_val_t (Alignment)));
+		}
+
+		void deallocate (T* pData, size_t) noexcept
+		{
+			::operator delete (pData, std::align_val_t (Alignment));
+		}
+
+		template <typename U>
+		bool operator == (const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	template <typename T, typename Allocator = std::allocator<T>>
 	struct DataBlock
 	{
 		DataBlock () = default;
@@ -59,7 +96,7 @@ namespace spc
 		[[nodiscard]] size_t GetSize () const noexcept { return m_data.size (); }
 		[[nodiscard]] const T* GetDataAt (size_t offset = 0) const noexcept { return &m_data.data ()[offset]; }
 		[[nodiscard]] T* GetDataPointer () const noexcept { return const_cast<T*>(m_data.data ()); }
-		[[nodiscard]] const std::vector<T> GetData () const noexcept { return m_data; }
+		[[nodiscard]] const std::vector<T, Allocator> GetData () const noexcept { return m_data; }
 
 		[[nodiscard]] T operator [] (int32_t offset) { return m_data.data ()[offset]; }
 
@@ -100,11 +137,26 @@ namespace spc
 			std::memmove (m_data.data () + currentSize, dataPointer, lengthOfData);
 		}
 
+		void Resize (size_t newSize) noexcept { m_data.resize (newSize); }
+
 	protected:
 
-		std::vector<T> m_data;
+		std::vector<T, Allocator> m_data;
 	};
 
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Data block whose storage meets the alignment of any logical block size
+	/// up to a page, transfer lengths must still be a multiple of the block size
+	/// </summary>
+
+	static constexpr size_t DirectBlockAlignment = 4096;
+
+	template <typename T>
+	using AlignedBlock = DataBlock<T, AlignedAllocator<T, DirectBlockAlignment>>;
+
+	using AlignedByteBlock = AlignedBlock<uint8_t>;
+
 	////////////////////////////////////////////////////////////////////////////
 	///
 
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _DURABLE_LOG_H_
+#define _DURABLE_LOG_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FileObject.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Append only log shared between threads. Append returns once the record
+	/// is on stable storage, records arriving while a sync is in progress are
+	/// gathered and committed together with a single fdatasync.
+	/// </summary>
+
+	class DurableLog
+	{
+	public:
+
+		DurableLog () noexcept;
+		virtual ~DurableLog () noexcept;
+
+		DurableLog (const DurableLog& from) = delete;
+		DurableLog (DurableLog&& from) = delete;
+		DurableLog& operator = (const DurableLog& from) = delete;
+		DurableLog& operator = (DurableLog&& from) = delete;
+
+		[[nodiscard]] bool IsOpen () const noexcept { return m_fileObject.IsOpen (); }
+		[[nodiscard]] bool Open (const std::string& pathName) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] bool Append (const uint8_t* pBuffer, size_t length) noexcept;
+		[[nodiscard]] bool Append (const std::string_view& record) noexcept
+		{
+			return Append (reinterpret_cast<const uint8_t*>(record.data ()), record.length ());
+		}
+
+		[[nodiscard]] uint64_t GetRecordCount () const noexcept { return m_recordCount; }
+		[[nodiscard]] uint64_t GetCommitCount () const noexcept { return m_commitCount; }
+
+	private:
+
+		struct Commit
+		{
+			bool m_complete = false;
+			bool m_durable = false;
+		};
+
+		std::mutex				m_logMutex;
+		std::condition_variable	m_commitDone;
+
+		FileObject				m_fileObject;
+		std::vector<uint8_t>	m_pendingData;
+		std::vector<uint8_t>	m_commitData;
+		std::shared_ptr<Commit>	m_pendingCommit;
+		bool					m_committing;
+
+		uint64_t				m_recordCount;
+		uint64_t				m_commitCount;
+	};
+}
+
+#endif
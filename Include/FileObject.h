@@ -24,8 +24,14 @@
 #ifndef _FILE_OBJECT_H_
 #define _FILE_OBJECT_H_
 
+#include <atomic>
+#include <chrono>
 #include <fcntl.h>
+#include <span>
 #include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -41,14 +47,16 @@ namespace spc
 	{
 	public:
 
+		enum class Access {Normal, Sequential, Random, WillNeed, DontNeed, NoReuse};
+
 		FileObject () noexcept;
 		virtual ~FileObject () noexcept;
 
-		FileObject (const FileObject& from)
+		FileObject (const FileObject& from) : FileObject ()
 		{
 			operator = (from);
 		}
-		FileObject (FileObject&& from)
+		FileObject (FileObject&& from) : FileObject ()
 		{
 			operator = (from);
 		}
@@ -56,31 +64,78 @@ namespace spc
 		{
 			m_handleId = from.m_handleId;
 			m_pathName = from.m_pathName;
+			m_directIO = from.m_directIO;
+			DiscardReadBuffer ();
 			return *this;
 		}
 		FileObject& operator = (FileObject&& from)
 		{
 			m_handleId = from.m_handleId;
 			m_pathName = from.m_pathName;
+			m_readBuffer.swap (from.m_readBuffer);
+			m_readOffset = from.m_readOffset;
+			m_readLength = from.m_readLength;
+			m_writeBuffer.swap (from.m_writeBuffer);
+			m_writeBufferSize = from.m_writeBufferSize;
+			m_flushInterval = from.m_flushInterval;
+			m_bufferedSince = from.m_bufferedSince;
+			m_syscallCount = from.m_syscallCount.load ();
+			m_directIO = from.m_directIO;
 			from.m_handleId = INVALID_HANDLE_VALUE;
 			from.m_pathName = "";
+			from.DiscardReadBuffer ();
 			return *this;
 		}
 
 		[[nodiscard]] bool IsOpen () const noexcept {return m_handleId != INVALID_HANDLE_VALUE;}
+		[[nodiscard]] int32_t GetHandle () const noexcept {return m_handleId;}
 		[[nodiscard]] bool Create (const std::string& pathName, mode_t mode = S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH) noexcept;
 		[[nodiscard]] bool Open (const std::string& pathName, bool appendOnly = false) noexcept;
-		[[nodiscard]] bool Write (const uint8_t* pBuffer, size_t length) const noexcept;
+		[[nodiscard]] bool OpenDirect (const std::string& pathName, bool create = false, mode_t mode = S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH) noexcept;
+		[[nodiscard]] bool IsDirect () const noexcept {return m_directIO;}
+		[[nodiscard]] size_t GetDirectAlignment () const noexcept;
+		[[nodiscard]] bool Write (const uint8_t* pBuffer, size_t length) noexcept;
 		[[nodiscard]] size_t Read (uint8_t* pBuffer, size_t length) noexcept;
+		[[nodiscard]] bool WriteV (std::span<const iovec> vectors) noexcept;
+		[[nodiscard]] bool WriteAt (const uint8_t* pBuffer, size_t length, off_t offset) const noexcept;
+		[[nodiscard]] size_t ReadAt (uint8_t* pBuffer, size_t length, off_t offset) const noexcept;
+		[[nodiscard]] bool Seek (off_t offset) noexcept;
 		[[nodiscard]] bool SeekEnd () noexcept;
+		[[nodiscard]] off_t Tell () noexcept;
+		[[nodiscard]] bool Flush () noexcept;
+		[[nodiscard]] bool Sync (bool dataOnly = true) noexcept;
 		void Close () noexcept;
 
+		[[nodiscard]] bool Truncate (off_t length) noexcept;
+		[[nodiscard]] bool Preallocate (off_t length, off_t offset = 0, bool keepSize = true) noexcept;
+		[[nodiscard]] bool Advise (Access access, off_t offset = 0, off_t length = 0) noexcept;
+		[[nodiscard]] bool StartWriteBack (off_t offset, off_t length) noexcept;
+		[[nodiscard]] bool WaitWriteBack (off_t offset, off_t length) noexcept;
+
+		void SetWriteBuffer (size_t bufferSize, uint32_t flushIntervalms = 0) noexcept;
+		[[nodiscard]] uint64_t GetSyscallCount () const noexcept { return m_syscallCount; }
+
 	protected:
 
 		static constexpr int32_t	INVALID_HANDLE_VALUE = -1;
 
+		[[nodiscard]] size_t FillReadBuffer () noexcept;
+		void DiscardReadBuffer () noexcept { m_readOffset = 0; m_readLength = 0; }
+		[[nodiscard]] bool WriteDirect (const uint8_t* pBuffer, size_t length) noexcept;
+
 		std::string		m_pathName;
 		int32_t			m_handleId;
+
+		std::vector<uint8_t>	m_readBuffer;
+		size_t			m_readOffset;
+		size_t			m_readLength;
+
+		std::vector<uint8_t>	m_writeBuffer;
+		size_t			m_writeBufferSize;
+		std::chrono::milliseconds	m_flushInterval;
+		std::chrono::steady_clock::time_point	m_bufferedSince;
+		mutable std::atomic<uint64_t>	m_syscallCount;
+		bool			m_directIO;
 	};
 
 	////////////////////////////////////////////////////////////////////////////
@@ -96,11 +151,14 @@ namespace spc
 		[[nodiscard]] bool WriteNewLine () noexcept;
 		[[nodiscard]] bool ReadNextLine (std::string& nextLine) noexcept;
 
+		void SetReadBufferSize (size_t bufferSize) noexcept;
+
 	private:
 
+		static constexpr size_t DefaultReadBufferSize = 64 * 1024;
 		static constexpr char CarriageReturn = '\r';
 		static constexpr char LineFeed = '\n';
-		static constexpr const char* NewLineString = "\r\n";
+		static constexpr std::string_view NewLineString = "\r\n";
 	};
 }
 
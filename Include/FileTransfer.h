@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _FILE_TRANSFER_H_
+#define _FILE_TRANSFER_H_
+
+#include <cstdint>
+#include <sys/types.h>
+
+#include "FileObject.h"
+#include "SocketObject.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Zero copy transfers between files and sockets. Data is moved inside the
+	/// kernel so it is never copied through user space. A length of zero
+	/// transfers everything from the offset to the end of the source file.
+	/// </summary>
+
+	class FileTransfer
+	{
+	public:
+
+		FileTransfer () = delete;
+
+		[[nodiscard]] static size_t FileToSocket (FileObject& fromFile, SocketObject& toSocket, off_t offset = 0, size_t length = 0) noexcept;
+		[[nodiscard]] static size_t FileToFile (FileObject& fromFile, FileObject& toFile, off_t offset = 0, size_t length = 0) noexcept;
+		[[nodiscard]] static size_t SocketToFile (SocketObject& fromSocket, FileObject& toFile, size_t length) noexcept;
+
+	private:
+
+		static constexpr size_t MaximumChunkSize = 1024 * 1024;
+		static constexpr size_t CopyBufferSize = 64 * 1024;
+
+		[[nodiscard]] static size_t RemainingLength (FileObject& fromFile, off_t offset, size_t length) noexcept;
+		[[nodiscard]] static size_t SendFile (int32_t toHandle, int32_t fromHandle, off_t offset, size_t length) noexcept;
+	};
+}
+
+#endif
@@ -45,6 +45,7 @@ namespace spc
 		virtual ~ISerialise () = default;
 
 		[[nodiscard]] bool IsOpen () const noexcept {return m_handleId != INVALID_HANDLE_VALUE;}
+		[[nodiscard]] int32_t GetHandle () const noexcept {return m_handleId;}
 
 		[[nodiscard]] virtual bool Send (const uint8_t* pBuffer, size_t length) = 0;
 		[[nodiscard]] virtual size_t Read (uint8_t* pBuffer, size_t length) = 0;
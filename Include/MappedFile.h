@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Read only memory mapped file class
+	/// </summary>
+
+	class MappedFile
+	{
+	public:
+
+		enum class Access {Normal, Sequential, Random, WillNeed, DontNeed};
+
+		MappedFile () noexcept;
+		virtual ~MappedFile () noexcept;
+
+		MappedFile (const MappedFile& from) = delete;
+		MappedFile (MappedFile&& from) = delete;
+		MappedFile& operator = (const MappedFile& from) = delete;
+		MappedFile& operator = (MappedFile&& from) = delete;
+
+		[[nodiscard]] bool IsOpen () const noexcept { return m_isOpen; }
+		[[nodiscard]] bool Open (const std::string& pathName, Access access = Access::Sequential) noexcept;
+		[[nodiscard]] bool Advise (Access access) noexcept { return Advise (access, 0, m_size); }
+		[[nodiscard]] bool Advise (Access access, size_t offset, size_t length) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] size_t GetSize () const noexcept { return m_size; }
+		[[nodiscard]] std::span<const uint8_t> GetData () const noexcept { return {m_pData, m_size}; }
+		[[nodiscard]] std::string_view GetText () const noexcept { return {reinterpret_cast<const char*>(m_pData), m_size}; }
+
+		[[nodiscard]] bool ReadNextLine (std::string_view& nextLine) noexcept;
+		[[nodiscard]] size_t GetOffset () const noexcept { return m_offset; }
+		void SetOffset (size_t offset) noexcept { m_offset = (offset < m_size) ? offset : m_size; }
+
+	private:
+
+		static constexpr char CarriageReturn = '\r';
+		static constexpr char LineFeed = '\n';
+
+		std::string		m_pathName;
+		const uint8_t*	m_pData;
+		size_t			m_size;
+		size_t			m_offset;
+		bool			m_isOpen;
+	};
+}
+
+#endif
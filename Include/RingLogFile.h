@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#ifndef _RING_LOG_FILE_H_
+#define _RING_LOG_FILE_H_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "FileObject.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// <summary>
+	/// Fixed size, memory mapped circular log. The file is a Header followed by
+	/// the data area. Each record is a 32 bit little endian length, 32 bits of
+	/// padding and the payload, rounded up to 8 bytes. A length of WrapMarker
+	/// means the rest of the data area is unused and the next record is at the
+	/// start. Records run from m_tail to m_head, oldest first, and the oldest
+	/// are dropped as new ones need the space.
+	/// </summary>
+
+	class RingLogFile
+	{
+	public:
+
+		struct Header
+		{
+			char		m_magic[8];
+			uint32_t	m_version;
+			uint32_t	m_headerSize;
+			uint64_t	m_capacity;
+			uint64_t	m_head;
+			uint64_t	m_tail;
+			uint64_t	m_used;
+			uint64_t	m_sequence;
+			uint64_t	m_reserved;
+		};
+
+		static_assert (sizeof (Header) == 64);
+
+		using RecordHandler = std::function<void (std::span<const uint8_t> record)>;
+
+		static constexpr const char Magic[8] = {'S', 'P', 'C', 'R', 'L', 'O', 'G', '1'};
+		static constexpr uint32_t Version = 1;
+		static constexpr uint32_t WrapMarker = 0xFFFFFFFF;
+		static constexpr uint64_t RecordAlignment = 8;
+		static constexpr uint64_t RecordHeaderSize = 8;
+
+		RingLogFile () noexcept;
+		virtual ~RingLogFile () noexcept;
+
+		RingLogFile (const RingLogFile& from) = delete;
+		RingLogFile (RingLogFile&& from) = delete;
+		RingLogFile& operator = (const RingLogFile& from) = delete;
+		RingLogFile& operator = (RingLogFile&& from) = delete;
+
+		[[nodiscard]] bool IsOpen () const noexcept { return m_pHeader != nullptr; }
+		[[nodiscard]] bool Create (const std::string& pathName, uint64_t capacity) noexcept;
+		[[nodiscard]] bool Open (const std::string& pathName) noexcept;
+		[[nodiscard]] bool Sync (bool wait = true) noexcept;
+		void Close () noexcept;
+
+		[[nodiscard]] bool Write (const uint8_t* pBuffer, uint32_t length) noexcept;
+		[[nodiscard]] bool Write (const std::string_view& record) noexcept
+		{
+			return Write (reinterpret_cast<const uint8_t*>(record.data ()), static_cast<uint32_t>(record.length ()));
+		}
+
+		[[nodiscard]] uint64_t GetCapacity () const noexcept { return (IsOpen ()) ? m_pHeader->m_capacity : 0; }
+		[[nodiscard]] uint64_t GetUsed () const noexcept { return (IsOpen ()) ? m_pHeader->m_used : 0; }
+		[[nodiscard]] uint64_t GetSequence () const noexcept { return (IsOpen ()) ? m_pHeader->m_sequence : 0; }
+
+		uint64_t ForEachRecord (const RecordHandler& recordHandler) noexcept;
+		[[nodiscard]] static bool ReadRecords (const std::string& pathName, const RecordHandler& recordHandler) noexcept;
+
+	private:
+
+		[[nodiscard]] bool Map () noexcept;
+		void MakeSpace (uint64_t length) noexcept;
+		static uint64_t WalkRecords (const Header& header, const uint8_t* pData, const RecordHandler& recordHandler) noexcept;
+
+		std::mutex		m_writeMutex;
+		FileObject		m_fileObject;
+		Header*			m_pHeader;
+		uint8_t*		m_pData;
+		size_t			m_mappedSize;
+	};
+}
+
+#endif
@@ -0,0 +1,389 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "AsyncFileIO.h"
+
+#include "spdlog/spdlog.h"
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	AsyncFileIO::AsyncFileIO () noexcept :
+		m_ringHandle (INVALID_HANDLE_VALUE),
+		m_eventHandle (INVALID_HANDLE_VALUE),
+		m_pending (0),
+		m_pSubmitRing (MAP_FAILED),
+		m_submitRingSize (0),
+		m_pCompleteRing (MAP_FAILED),
+		m_completeRingSize (0),
+		m_pSubmitEntries (nullptr),
+		m_submitEntriesSize (0),
+		m_pSubmitHead (nullptr),
+		m_pSubmitTail (nullptr),
+		m_pSubmitArray (nullptr),
+		m_submitMask (0),
+		m_submitEntryCount (0),
+		m_pCompleteHead (nullptr),
+		m_pCompleteTail (nullptr),
+		m_pCompleteEntries (nullptr),
+		m_completeMask (0)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	AsyncFileIO::~AsyncFileIO () noexcept
+	{
+		Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool AsyncFileIO::Initialise (uint32_t queueDepth) noexcept
+	{
+		Close ();
+
+		io_uring_params params {};
+
+		m_ringHandle = static_cast<int32_t>(syscall (__NR_io_uring_setup, queueDepth, &params));
+		if (m_ringHandle < 0)
+		{
+			spdlog::error ("Failed to create io_uring with error number {0}", errno);
+			m_ringHandle = INVALID_HANDLE_VALUE;
+			return false;
+		}
+
+		m_submitRingSize = params.sq_off.array + params.sq_entries * sizeof (uint32_t);
+		m_completeRingSize = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+
+		// Newer kernels share a single mapping between both rings
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+		{
+			m_submitRingSize = std::max (m_submitRingSize, m_completeRingSize);
+			m_completeRingSize = 0;
+		}
+
+		m_pSubmitRing = mmap (nullptr, m_submitRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, m_ringHandle, IORING_OFF_SQ_RING);
+		if (m_pSubmitRing != MAP_FAILED && m_completeRingSize != 0)
+		{
+			m_pCompleteRing = mmap (nullptr, m_completeRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, m_ringHandle, IORING_OFF_CQ_RING);
+		}
+
+		m_submitEntriesSize = params.sq_entries * sizeof (io_uring_sqe);
+		void* pEntries = mmap (nullptr, m_submitEntriesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, m_ringHandle, IORING_OFF_SQES);
+		m_pSubmitEntries = (pEntries == MAP_FAILED) ? nullptr : static_cast<io_uring_sqe*>(pEntries);
+
+		if (m_pSubmitRing == MAP_FAILED || m_pSubmitEntries == nullptr || (m_completeRingSize != 0 && m_pCompleteRing == MAP_FAILED))
+		{
+			spdlog::error ("Failed to map io_uring rings with error number {0}", errno);
+			Close ();
+			return false;
+		}
+
+		uint8_t* pSubmit = static_cast<uint8_t*>(m_pSubmitRing);
+		uint8_t* pComplete = (m_completeRingSize != 0) ? static_cast<uint8_t*>(m_pCompleteRing) : pSubmit;
+
+		m_pSubmitHead = reinterpret_cast<uint32_t*>(pSubmit + params.sq_off.head);
+		m_pSubmitTail = reinterpret_cast<uint32_t*>(pSubmit + params.sq_off.tail);
+		m_pSubmitArray = reinterpret_cast<uint32_t*>(pSubmit + params.sq_off.array);
+		m_submitMask = *reinterpret_cast<uint32_t*>(pSubmit + params.sq_off.ring_mask);
+		m_submitEntryCount = params.sq_entries;
+
+		m_pCompleteHead = reinterpret_cast<uint32_t*>(pComplete + params.cq_off.head);
+		m_pCompleteTail = reinterpret_cast<uint32_t*>(pComplete + params.cq_off.tail);
+		m_pCompleteEntries = reinterpret_cast<io_uring_cqe*>(pComplete + params.cq_off.cqes);
+		m_completeMask = *reinterpret_cast<uint32_t*>(pComplete + params.cq_off.ring_mask);
+
+		m_eventHandle = eventfd (0, EFD_NONBLOCK|EFD_CLOEXEC);
+		if (m_eventHandle < 0 || syscall (__NR_io_uring_register, m_ringHandle, IORING_REGISTER_EVENTFD, &m_eventHandle, 1) != 0)
+		{
+			spdlog::error ("Failed to register io_uring event handle with error number {0}", errno);
+			Close ();
+			return false;
+		}
+
+		// Requests in flight are capped at the submission depth so the completion ring can never overflow
+		m_requests.resize (params.sq_entries);
+		m_freeSlots.clear ();
+		m_completedSlots.reserve (params.sq_entries);
+		for (uint32_t slotIndex = params.sq_entries; slotIndex > 0; --slotIndex)
+		{
+			m_freeSlots.push_back (slotIndex - 1);
+		}
+
+		spdlog::info ("Created io_uring with {0} entries", params.sq_entries);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void AsyncFileIO::Close () noexcept
+	{
+		if (IsOpen ())
+		{
+			while (m_pending > 0 && m_pSubmitEntries != nullptr)
+			{
+				if (WaitCompletions () == 0) break;
+			}
+		}
+
+		if (m_pSubmitEntries != nullptr) munmap (m_pSubmitEntries, m_submitEntriesSize);
+		if (m_pCompleteRing != MAP_FAILED) munmap (m_pCompleteRing, m_completeRingSize);
+		if (m_pSubmitRing != MAP_FAILED) munmap (m_pSubmitRing, m_submitRingSize);
+		if (m_eventHandle != INVALID_HANDLE_VALUE) close (m_eventHandle);
+		if (m_ringHandle != INVALID_HANDLE_VALUE) close (m_ringHandle);
+
+		m_pSubmitEntries = nullptr;
+		m_pCompleteRing = MAP_FAILED;
+		m_pSubmitRing = MAP_FAILED;
+		m_eventHandle = INVALID_HANDLE_VALUE;
+		m_ringHandle = INVALID_HANDLE_VALUE;
+		m_pending = 0;
+
+		m_requests.clear ();
+		m_freeSlots.clear ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	io_uring_sqe* AsyncFileIO::NextSubmission (uint32_t& slotIndex) noexcept
+	{
+		if (!IsOpen ()) return nullptr;
+
+		uint32_t tail = *m_pSubmitTail;
+		uint32_t head = std::atomic_ref<uint32_t> (*m_pSubmitHead).load (std::memory_order_acquire);
+
+		if (m_freeSlots.empty () || tail - head >= m_submitEntryCount)
+		{
+			spdlog::debug ("io_uring submission queue full");
+			return nullptr;
+		}
+
+		slotIndex = m_freeSlots.back ();
+		m_freeSlots.pop_back ();
+
+		io_uring_sqe* pEntry = &m_pSubmitEntries[tail & m_submitMask];
+		std::memset (pEntry, 0, sizeof (io_uring_sqe));
+
+		// Always hand the work to the kernel workers so the caller never blocks on the device,
+		// writes to the same regular file are still serialised in submission order by the kernel
+		pEntry->flags = IOSQE_ASYNC;
+		pEntry->user_data = slotIndex;
+		return pEntry;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool AsyncFileIO::Submit (uint32_t slotIndex) noexcept
+	{
+		uint32_t tail = *m_pSubmitTail;
+		uint32_t index = tail & m_submitMask;
+
+		m_pSubmitArray[index] = index;
+		std::atomic_ref<uint32_t> (*m_pSubmitTail).store (tail + 1, std::memory_order_release);
+
+		++m_pending;
+
+		if (syscall (__NR_io_uring_enter, m_ringHandle, 1, 0, 0, nullptr, 0) < 0)
+		{
+			// The entry is still queued and will go with the next submission
+			spdlog::error ("Failed to submit io_uring request {0} with error number {1}", slotIndex, errno);
+			return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool AsyncFileIO::SubmitWrite (const FileObject& fileObject, const uint8_t* pBuffer, size_t length,
+		off_t offset, Completion completion) noexcept
+	{
+		if (length == 0 || !fileObject.IsOpen ()) return false;
+
+		std::scoped_lock lock (m_ringMutex);
+
+		uint32_t slotIndex = 0;
+		io_uring_sqe* pEntry = NextSubmission (slotIndex);
+		if (pEntry == nullptr) return false;
+
+		// The data is copied so the caller can reuse its buffer straight away
+		Request& request = m_requests[slotIndex];
+		request.m_data.assign (pBuffer, pBuffer + length);
+		request.m_completion = std::move (completion);
+
+		pEntry->opcode = IORING_OP_WRITE;
+		pEntry->fd = fileObject.GetHandle ();
+		pEntry->addr = reinterpret_cast<uint64_t>(request.m_data.data ());
+		pEntry->len = static_cast<uint32_t>(length);
+		pEntry->off = static_cast<uint64_t>(offset);
+
+		return Submit (slotIndex);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool AsyncFileIO::SubmitRead (const FileObject& fileObject, uint8_t* pBuffer, size_t length,
+		off_t offset, Completion completion) noexcept
+	{
+		if (length == 0 || !fileObject.IsOpen ()) return false;
+
+		std::scoped_lock lock (m_ringMutex);
+
+		uint32_t slotIndex = 0;
+		io_uring_sqe* pEntry = NextSubmission (slotIndex);
+		if (pEntry == nullptr) return false;
+
+		m_requests[slotIndex].m_completion = std::move (completion);
+
+		pEntry->opcode = IORING_OP_READ;
+		pEntry->fd = fileObject.GetHandle ();
+		pEntry->addr = reinterpret_cast<uint64_t>(pBuffer);
+		pEntry->len = static_cast<uint32_t>(length);
+		pEntry->off = static_cast<uint64_t>(offset);
+
+		return Submit (slotIndex);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool AsyncFileIO::SubmitSync (const FileObject& fileObject, bool dataOnly, Completion completion) noexcept
+	{
+		if (!fileObject.IsOpen ()) return false;
+
+		std::scoped_lock lock (m_ringMutex);
+
+		uint32_t slotIndex = 0;
+		io_uring_sqe* pEntry = NextSubmission (slotIndex);
+		if (pEntry == nullptr) return false;
+
+		m_requests[slotIndex].m_completion = std::move (completion);
+
+		pEntry->opcode = IORING_OP_FSYNC;
+		pEntry->fd = fileObject.GetHandle ();
+		pEntry->fsync_flags = (dataOnly) ? IORING_FSYNC_DATASYNC : 0;
+
+		return Submit (slotIndex);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	uint32_t AsyncFileIO::ProcessCompletions () noexcept
+	{
+		if (!IsOpen ()) return 0;
+
+		std::scoped_lock completeLock (m_completeMutex);
+
+		uint64_t eventCount = 0;
+		if (read (m_eventHandle, &eventCount, sizeof (eventCount)) < 0 && errno != EAGAIN)
+		{
+			spdlog::error ("Unable to read io_uring event handle with error number {0}", errno);
+		}
+
+		m_completedSlots.clear ();
+
+		{
+			std::scoped_lock ringLock (m_ringMutex);
+
+			uint32_t head = *m_pCompleteHead;
+			uint32_t tail = std::atomic_ref<uint32_t> (*m_pCompleteTail).load (std::memory_order_acquire);
+
+			while (head != tail)
+			{
+				const io_uring_cqe& entry = m_pCompleteEntries[head & m_completeMask];
+				uint32_t slotIndex = static_cast<uint32_t>(entry.user_data);
+
+				m_requests[slotIndex].m_result = entry.res;
+				m_completedSlots.push_back (slotIndex);
+				++head;
+			}
+
+			std::atomic_ref<uint32_t> (*m_pCompleteHead).store (head, std::memory_order_release);
+		}
+
+		// Callbacks run without the ring lock so they may submit further requests
+		for (uint32_t slotIndex : m_completedSlots)
+		{
+			Request& request = m_requests[slotIndex];
+
+			if (request.m_result < 0)
+			{
+				spdlog::error ("io_uring request {0} failed with error number {1}", slotIndex, -request.m_result);
+			}
+
+			if (request.m_completion) request.m_completion (request.m_result);
+			request.m_completion = nullptr;
+
+			std::scoped_lock ringLock (m_ringMutex);
+			m_freeSlots.push_back (slotIndex);
+			--m_pending;
+		}
+
+		return static_cast<uint32_t>(m_completedSlots.size ());
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	uint32_t AsyncFileIO::WaitCompletions (uint32_t minimum) noexcept
+	{
+		if (!IsOpen ()) return 0;
+
+		minimum = std::min (minimum, m_pending.load ());
+
+		if (minimum > 0 && syscall (__NR_io_uring_enter, m_ringHandle, 0, minimum, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+		{
+			if (errno != EINTR)
+			{
+				spdlog::error ("Failed waiting on io_uring with error number {0}", errno);
+				return 0;
+			}
+		}
+
+		return ProcessCompletions ();
+	}
+}
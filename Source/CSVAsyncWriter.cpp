@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVAsyncWriter.h"
+
+#include "spdlog/spdlog.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVAsyncWriter::CSVAsyncWriter (CSVColumnCollection& columnCollection, size_t queueSize) :
+		Thread ("CSVAsyncWriter", WriterDelayus),
+		m_columnCollection (columnCollection),
+		m_writer (columnCollection),
+		m_queue (queueSize),
+		m_batchSize (DefaultBatchSize),
+		m_isOpen (false),
+		m_pushed (0),
+		m_dropped (0),
+		m_written (0),
+		m_failed (0),
+		m_batches (0),
+		m_highWater (0)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// The thread has to be stopped here, by the time the Thread destructor
+	/// runs this class has gone and its ThreadStop can no longer be called
+
+	CSVAsyncWriter::~CSVAsyncWriter ()
+	{
+		Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVAsyncWriter::Open (const std::string& filePath, bool append, bool writeHeader, off_t reserveBytes)
+	{
+		Close ();
+
+		if (!m_writer.Open (filePath, append, reserveBytes)) return false;
+		m_writer.SetWriteBuffer (WriteBufferSize);
+
+		// The header goes out before the thread starts so it is always first
+		if (writeHeader && (!m_writer.WriteHeader () || !m_writer.Flush ()))
+		{
+			m_writer.Close ();
+			return false;
+		}
+
+		m_isOpen = true;
+		StartExecution ();
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVAsyncWriter::Close ()
+	{
+		if (!m_isOpen) return;
+
+		StopExecution ();
+		m_writer.Close ();
+		m_isOpen = false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVAsyncWriter::Push (const CSVRecord& record) noexcept
+	{
+		CSVRecord stampedRecord = record;
+		timespec now {};
+
+		(void)clock_gettime (CLOCK_REALTIME, &now);
+		stampedRecord.SetTime (now);
+
+		if (!m_queue.TryPush (stampedRecord))
+		{
+			m_dropped.fetch_add (1, std::memory_order_relaxed);
+			return false;
+		}
+
+		m_pushed.fetch_add (1, std::memory_order_relaxed);
+		UpdateHighWater (m_queue.Size ());
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVAsyncStatistics CSVAsyncWriter::GetStatistics () const noexcept
+	{
+		CSVAsyncStatistics statistics;
+
+		statistics.pushed = m_pushed.load (std::memory_order_relaxed);
+		statistics.dropped = m_dropped.load (std::memory_order_relaxed);
+		statistics.written = m_written.load (std::memory_order_relaxed);
+		statistics.failed = m_failed.load (std::memory_order_relaxed);
+		statistics.batches = m_batches.load (std::memory_order_relaxed);
+		statistics.highWater = m_highWater.load (std::memory_order_relaxed);
+		statistics.capacity = m_queue.Capacity ();
+
+		return statistics;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// A full batch means more are probably waiting so go straight round again
+
+	Thread::TaskAction CSVAsyncWriter::ThreadMethod () noexcept
+	{
+		return (WriteBatch (m_batchSize) == m_batchSize) ? TaskAction::NoWait : TaskAction::Wait;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Runs on the writer thread as it stops, so nothing queued is lost
+
+	void CSVAsyncWriter::ThreadStop () noexcept
+	{
+		while (WriteBatch (m_batchSize) > 0) {}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t CSVAsyncWriter::WriteBatch (size_t maximumRecords) noexcept
+	{
+		CSVRecord record;
+		size_t recordCount = 0;
+		uint64_t rowsWritten = 0;
+
+		while (recordCount < maximumRecords && m_queue.TryPop (record))
+		{
+			for (uint32_t index = 0; index < m_columnCollection.Length () && index < CSVRecord::MaximumColumns; ++index)
+			{
+				switch (m_columnCollection[index].GetType ())
+				{
+				case	CSVColumn::Type::Int:
+					m_writer.SetIntegerAt (index, record.GetIntegerAt (index));
+					break;
+
+				case	CSVColumn::Type::Float:
+					m_writer.SetFloatAt (index, record.GetFloatAt (index));
+					break;
+
+				case	CSVColumn::Type::String:
+					m_text.assign (record.GetStringAt (index));
+					m_writer.SetStringAt (index, m_text);
+					break;
+
+				default:
+					// Row, Date and Time are filled in by the writer
+					break;
+				}
+			}
+
+			if (m_writer.WriteLine (record.GetTime ()))
+			{
+				++rowsWritten;
+			}
+			else
+			{
+				m_failed.fetch_add (1, std::memory_order_relaxed);
+			}
+
+			++recordCount;
+		}
+
+		if (recordCount == 0) return 0;
+
+		// Rows only count as written once the batch has left the write buffer
+		if (m_writer.Flush ())
+		{
+			m_written.fetch_add (rowsWritten, std::memory_order_relaxed);
+		}
+		else
+		{
+			spdlog::error ("CSV writer failed to flush a batch of {0} rows", rowsWritten);
+			m_failed.fetch_add (rowsWritten, std::memory_order_relaxed);
+		}
+
+		m_batches.fetch_add (1, std::memory_order_relaxed);
+		return recordCount;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVAsyncWriter::UpdateHighWater (size_t queueSize) noexcept
+	{
+		size_t highWater = m_highWater.load (std::memory_order_relaxed);
+
+		while (queueSize > highWater && !m_highWater.compare_exchange_weak (highWater, queueSize, std::memory_order_relaxed))
+		{
+		}
+	}
+}
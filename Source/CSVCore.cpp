@@ -22,6 +22,7 @@
 /// THE SOFTWARE.
 
 #include "CSVCore.h"
+#include "CSVFormat.h"
 
 #include <iostream>
 
@@ -33,39 +34,13 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////
 	///
 
-	CSVColumn::CSVColumn (Type type, std::string columnName, uint8_t width, uint8_t precision, bool leftJustified)
+	CSVColumn::CSVColumn (Type type, std::string columnName, uint8_t width, uint8_t precision, bool leftJustified) :
+		m_columnName (columnName),
+		m_precision (precision),
+		m_width (width),
+		m_leftJustified (leftJustified),
+		m_type (type)
 	{
-		char format[TEMPORARY_BUFFER_SIZE];
-
-		char* pDst = format;
-
-		if (leftJustified) *pDst++ = '-';
-
-		// Depending on type...
-		switch (type)
-		{
-		case	Type::Date: break;
-		case	Type::Time: break;
-
-		case	Type::String:
-			sprintf (pDst, "%%.%ds", width);
-			break;
-
-		case	Type::Row:
-		case	Type::Int:
-			sprintf (pDst, "%%%d.%dd", width, precision);
-			break;
-
-		case	Type::Float:
-			sprintf (pDst, "%%%d.%df", width, precision);
-			break;
-		}
-
-		m_formatText = format;
-		m_columnName = columnName;
-		m_precision = precision;
-		m_width = width;
-		m_type = type;
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -73,10 +48,7 @@ namespace spc
 
 	void CSVColumn::Format (const std::string& text)
 	{
-		char formattedText[128];
-
-		sprintf (formattedText, m_formatText.c_str (), text.c_str ());
-		m_formattedText = formattedText;
+		m_formattedText.assign (CSVFormat::FormatString (text, m_width));
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -86,13 +58,13 @@ namespace spc
 	{
 		if (value == 0)
 		{
-			m_formattedText = std::string ("0");
+			m_formattedText.assign (1, '0');
 			return;
 		}
 
-		char formattedText[TEMPORARY_BUFFER_SIZE];
-		sprintf (formattedText, m_formatText.c_str (), value);
-		m_formattedText = formattedText;
+		// Assigning into the existing string reuses its capacity so no allocation
+		char formattedText[CSVFormat::MaximumFieldSize];
+		m_formattedText.assign (formattedText, CSVFormat::FormatInteger (formattedText, value, m_width, m_precision, m_leftJustified));
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -100,17 +72,16 @@ namespace spc
 
 	void CSVColumn::Format (float value)
 	{
-		char formattedText[TEMPORARY_BUFFER_SIZE];
-		sprintf (formattedText, m_formatText.c_str (), value);
-		m_formattedText = formattedText;
+		char formattedText[CSVFormat::MaximumFieldSize];
+		m_formattedText.assign (formattedText, CSVFormat::FormatFloat (formattedText, value, m_width, m_precision, m_leftJustified));
 	}
 
 	////////////////////////////////////////////////////////////////////////////
-	///
+	/// Text that does not parse reads as zero
 
 	double CSVColumn::GetValueAsDouble () const noexcept
 	{
-		return std::stod (m_formattedText);
+		return GetValueAs<double> ().ValueOr (0.0);
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -118,7 +89,7 @@ namespace spc
 
 	float CSVColumn::GetValueAsFloat () const noexcept
 	{
-		return std::stof (m_formattedText);
+		return GetValueAs<float> ().ValueOr (0.0f);
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -126,7 +97,7 @@ namespace spc
 
 	int32_t CSVColumn::GetValueAsInt () const noexcept
 	{
-		return std::stoi (m_formattedText);
+		return GetValueAs<int32_t> ().ValueOr (0);
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -134,24 +105,34 @@ namespace spc
 
 	void CSVColumn::FormatFixed (uint32_t rowNumber)
 	{
-		char formattedText[TEMPORARY_BUFFER_SIZE];
-		Clock clock;
+		CSVTimestamp timestamp;
+		timespec now {};
+
+		clock_gettime (CLOCK_REALTIME, &now);
+		timestamp.Update (now);
+		FormatFixed (rowNumber, timestamp);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// A Time column's precision is the number of decimal places on the
+	/// seconds, 3 for milliseconds or 6 for microseconds
+
+	void CSVColumn::FormatFixed (uint32_t rowNumber, const CSVTimestamp& rowTime)
+	{
+		char formattedText[CSVFormat::MaximumFieldSize];
 
 		switch (m_type)
 		{
 		case	CSVColumn::Type::Row:
-			sprintf (formattedText, m_formatText.c_str (), rowNumber);
-			m_formattedText = formattedText;
+			m_formattedText.assign (formattedText, CSVFormat::FormatInteger (formattedText, rowNumber, m_width, m_precision, m_leftJustified));
 			break;
 
 		case	CSVColumn::Type::Date:
-			clock = Clock::Now ();
-			m_formattedText = clock.GetASCIIDate ();
+			m_formattedText.assign (rowTime.GetDate ());
 			break;
 
 		case	CSVColumn::Type::Time:
-			clock = Clock::Now ();
-			m_formattedText = clock.GetASCIITime ();
+			m_formattedText.assign (formattedText, rowTime.FormatTime (formattedText, m_precision));
 			break;
 
 		default:
@@ -167,9 +148,9 @@ namespace spc
 	{
 		m_formattedText = from.m_formattedText;
 		m_columnName = from.m_columnName;
-		m_formatText = from.m_formatText;
 		m_precision = from.m_precision;
 		m_width = from.m_width;
+		m_leftJustified = from.m_leftJustified;
 		m_type = from.m_type;
 		return *this;
 	}
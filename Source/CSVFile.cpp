@@ -22,7 +22,13 @@
 /// THE SOFTWARE.
 
 #include <CSVFile.h>
+#include <CSVRollupWriter.h>
+#include <CSVScanner.h>
+
+#include "spdlog/spdlog.h"
+
 #include <algorithm>
+#include <sys/stat.h>
 
 ////////////////////////////////////////////////////////////////////////////////
 ///
@@ -32,14 +38,32 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////
 	///
 
-	bool CSVWriter::Open (const std::string& filePath, bool append) noexcept
+	bool CSVWriter::Open (const std::string& filePath, bool append, off_t reserveBytes) noexcept
 	{
-		if (append)
+		if (append && m_fileObject.Open (filePath, true))
 		{
-			if (m_fileObject.Open (filePath, true)) return true;
+			(void)m_fileObject.SeekEnd ();
 		}
+		else if (!m_fileObject.Create (filePath))
+		{
+			return false;
+		}
+
+		m_fileOffset = std::max (m_fileObject.Tell (), static_cast<off_t>(0));
+		m_writeBackOffset = m_fileOffset;
+		m_lineCount = 0;
+
+		// The file is still usable without an index, it just cannot be searched
+		if (m_indexInterval > 0 && !OpenIndex (filePath))
+		{
+			spdlog::warn ("Writing {0} without an index", filePath);
+		}
+
+		// Space is reserved without changing the size so readers never see the tail
+		if (reserveBytes > 0) (void)m_fileObject.Preallocate (reserveBytes, m_fileOffset);
+		(void)m_fileObject.Advise (FileObject::Access::Sequential);
 
-		return m_fileObject.Create (filePath);
+		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -53,6 +77,7 @@ namespace spc
 		}
 
 		m_fileObject.Close ();
+		m_index.Close ();
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -61,17 +86,20 @@ namespace spc
 	bool CSVWriter::WriteHeader () noexcept
 	{
 		m_columnCollection.SetFixedColumns ();
+		m_rowVectors.clear ();
 
 		for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
 		{
-			if (index != 0)
-			{
-				if (!m_fileObject.WriteString (CommaSeparator)) return false;
-			}
-			if (!m_fileObject.WriteString (m_columnCollection[index].GetName ())) return false;
+			if (index != 0) AddVector (CommaSeparator);
+			AddVector (m_columnCollection[index].GetName ());
 		}
 
-		return m_fileObject.WriteNewLine ();
+		AddVector (NewLine);
+
+		if (!m_fileObject.WriteV (m_rowVectors)) return false;
+
+		++m_lineCount;
+		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -79,25 +107,101 @@ namespace spc
 
 	bool CSVWriter::WriteLine () noexcept
 	{
-		bool writeValid = true;
-		m_columnCollection.SetFixedColumns ();
+		timespec now {};
+		clock_gettime (CLOCK_REALTIME, &now);
+		return WriteLine (now);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVWriter::WriteLine (const timespec& rowTime) noexcept
+	{
+		const off_t lineOffset = m_fileOffset;
 
-		for (uint32_t index = 0; index < m_columnCollection.Length () && writeValid; ++index)
+		m_columnCollection.SetFixedColumns (rowTime);
+		m_rowVectors.clear ();
+
+		// The whole row goes out in one gather write straight from the column text
+		for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
 		{
-			if (index != 0)
+			if (index != 0) AddVector (CommaSeparator);
+			AddVector (m_columnCollection[index].GetValueAsText ());
+		}
+
+		AddVector (NewLine);
+
+		if (!m_fileObject.WriteV (m_rowVectors)) return false;
+
+		if (m_indexInterval > 0 && m_lineCount % m_indexInterval == 0)
+		{
+			(void)m_index.Append ({m_lineCount, lineOffset, rowTime.tv_sec});
+		}
+
+		++m_lineCount;
+
+		// The rollups need the values before they are cleared
+		if (m_pRollupWriter != nullptr) (void)m_pRollupWriter->Add (rowTime);
+
+		ClearLine ();
+		if (m_releaseChunk > 0) ReleaseCache ();
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVWriter::ReleaseCache () noexcept
+	{
+		// Start write back of each chunk as it fills, then once the previous
+		// chunk is on disk drop it from the page cache as it is never read
+		while (m_fileOffset - m_writeBackOffset >= m_releaseChunk)
+		{
+			(void)m_fileObject.StartWriteBack (m_writeBackOffset, m_releaseChunk);
+
+			if (m_writeBackOffset >= m_releaseChunk)
 			{
-				if (!m_fileObject.WriteString (CommaSeparator)) writeValid = false;
+				off_t previousChunk = m_writeBackOffset - m_releaseChunk;
+				if (m_fileObject.WaitWriteBack (previousChunk, m_releaseChunk))
+				{
+					(void)m_fileObject.Advise (FileObject::Access::DontNeed, previousChunk, m_releaseChunk);
+				}
 			}
-			if (!m_fileObject.WriteString (m_columnCollection[index].GetValueAsText ())) writeValid = false;
+
+			m_writeBackOffset += m_releaseChunk;
 		}
+	}
 
-		if (writeValid)
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVWriter::OpenIndex (const std::string& filePath) noexcept
+	{
+		if (!m_index.OpenForWriting (filePath, m_fileOffset)) return false;
+
+		// Rows added since the last entry are counted so numbering carries on
+		const std::vector<CSVIndex::Entry>& entries = m_index.GetEntries ();
+		off_t countOffset = entries.empty () ? 0 : entries.back ().m_offset;
+		m_lineCount = entries.empty () ? 0 : entries.back ().m_row;
+
+		if (countOffset < m_fileOffset)
 		{
-			ClearLine ();
-			if (!m_fileObject.WriteNewLine ()) return false;
+			MappedFile mappedFile;
+			if (!mappedFile.Open (filePath)) return false;
+
+			std::string_view nextLine;
+			bool readValid = true;
+
+			mappedFile.SetOffset (countOffset);
+
+			while (readValid)
+			{
+				readValid = mappedFile.ReadNextLine (nextLine);
+				if (!nextLine.empty ()) ++m_lineCount;
+			}
 		}
 
-		return writeValid;
+		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -105,15 +209,161 @@ namespace spc
 
 	bool CSVReader::Open (const std::string& filePath) noexcept
 	{
+		Close ();
+		m_filePath = filePath;
 		return m_fileObject.Open (filePath);
 	}
 
 	////////////////////////////////////////////////////////////////////////////
 	///
 
+	bool CSVReader::OpenMapped (const std::string& filePath) noexcept
+	{
+		Close ();
+		m_filePath = filePath;
+		return m_mappedFile.Open (filePath, MappedFile::Access::Sequential);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
 	void CSVReader::Close () noexcept
 	{
 		m_fileObject.Close ();
+		m_mappedFile.Close ();
+		m_index.Close ();
+		m_indexLoaded = false;
+		m_filePath.clear ();
+		ResetScan ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::SeekToRow (uint64_t row) noexcept
+	{
+		LoadIndex ();
+
+		const CSVIndex::Entry* pEntry = m_index.FindRow (row);
+		uint64_t currentRow = (pEntry != nullptr) ? pEntry->m_row : 0;
+
+		if (!SeekToOffset ((pEntry != nullptr) ? pEntry->m_offset : 0)) return false;
+
+		for (; currentRow < row; ++currentRow)
+		{
+			if (!SkipLine ()) return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Narrows the search with the index if there is one and then by bisecting
+	/// the file, and finally reads forward to the first row at or after the
+	/// time. Rows are expected to be in time order.
+
+	bool CSVReader::SeekToTime (time_t time) noexcept
+	{
+		uint32_t dateColumn = 0;
+		uint32_t timeColumn = 0;
+
+		if (!FindTimeColumns (dateColumn, timeColumn))
+		{
+			spdlog::error ("Unable to seek by time without Date and Time columns");
+			return false;
+		}
+
+		LoadIndex ();
+
+		const std::vector<CSVIndex::Entry>& entries = m_index.GetEntries ();
+		const CSVIndex::Entry* pEntry = m_index.FindTime (time);
+		size_t nextEntry = (pEntry != nullptr) ? static_cast<size_t>(pEntry - entries.data ()) + 1 : 0;
+
+		off_t lowOffset = (pEntry != nullptr) ? pEntry->m_offset : 0;
+		off_t highOffset = (nextEntry < entries.size ()) ? entries[nextEntry].m_offset : GetFileSize ();
+
+		if (!SeekToOffset (SearchTime (time, lowOffset, highOffset, dateColumn, timeColumn))) return false;
+
+		while (true)
+		{
+			off_t lineOffset = 0;
+			time_t rowTime = 0;
+			bool readValid = false;
+
+			if (!ReadFieldsTime (dateColumn, timeColumn, lineOffset, rowTime, readValid)) return false;
+			if (rowTime >= time) return SeekToOffset (lineOffset);
+			if (!readValid) return false;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::QueryTimeRange (time_t start, time_t end, const RowHandler& handler) noexcept
+	{
+		uint32_t dateColumn = 0;
+		uint32_t timeColumn = 0;
+
+		if (!SeekToTime (start) || !FindTimeColumns (dateColumn, timeColumn)) return false;
+
+		while (true)
+		{
+			off_t lineOffset = 0;
+			time_t rowTime = 0;
+			bool readValid = false;
+
+			if (!ReadFieldsTime (dateColumn, timeColumn, lineOffset, rowTime, readValid) || rowTime >= end) break;
+			if (!handler (*this, rowTime) || !readValid) break;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Reads forward to the next row with a valid time, lines such as a header
+	/// are passed over. Returns false at the end of the file.
+
+	bool CSVReader::ReadFieldsTime (uint32_t dateColumn, uint32_t timeColumn, off_t& lineOffset, time_t& rowTime, bool& readValid) noexcept
+	{
+		while (true)
+		{
+			lineOffset = GetReadOffset ();
+			readValid = ReadFields ();
+
+			if (m_fields.empty () || lineOffset < 0) return false;
+			if (m_timeParser.ParseTimestamp (GetField (dateColumn), GetField (timeColumn), rowTime)) return true;
+			if (!readValid) return false;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Bisects the byte range, each probe skips to the start of the next line
+	/// and reads the first time found there. The returned offset is the start
+	/// of a row before the time, or the low offset, so reading forward from it
+	/// finds the first row at or after the time.
+
+	off_t CSVReader::SearchTime (time_t time, off_t lowOffset, off_t highOffset, uint32_t dateColumn, uint32_t timeColumn) noexcept
+	{
+		while (highOffset - lowOffset > LinearSearchSize)
+		{
+			off_t middleOffset = lowOffset + ((highOffset - lowOffset) / 2);
+			off_t lineOffset = 0;
+			time_t rowTime = 0;
+			bool readValid = false;
+
+			if (!SeekToOffset (middleOffset)) return lowOffset;
+
+			if (SkipLine () && ReadFieldsTime (dateColumn, timeColumn, lineOffset, rowTime, readValid) && rowTime < time)
+			{
+				lowOffset = lineOffset;
+			}
+			else
+			{
+				highOffset = middleOffset;
+			}
+		}
+
+		return lowOffset;
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -121,7 +371,14 @@ namespace spc
 
 	bool CSVReader::ReadHeader () noexcept
 	{
-		if (ReadLine ())
+		// Every name is needed whatever columns are selected
+		std::vector<bool> selected;
+		selected.swap (m_selected);
+
+		bool readValid = ReadLine ();
+		m_selected.swap (selected);
+
+		if (readValid)
 		{
 			for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
 			{
@@ -137,28 +394,298 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////
 	///
 
-	bool CSVReader::ReadLine () noexcept
+	bool CSVReader::SelectColumns (const std::vector<uint32_t>& columns) noexcept
+	{
+		try
+		{
+			std::vector<bool> selected;
+			uint32_t dateColumn = 0;
+			uint32_t timeColumn = 0;
+
+			for (uint32_t column : columns)
+			{
+				if (column >= selected.size ()) selected.resize (column + 1, false);
+				selected[column] = true;
+			}
+
+			if (FindTimeColumns (dateColumn, timeColumn))
+			{
+				selected.resize (std::max<size_t> (selected.size (), std::max (dateColumn, timeColumn) + 1), false);
+				selected[dateColumn] = selected[timeColumn] = true;
+			}
+
+			m_selected.swap (selected);
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to select CSV columns with error {0}", e.what ());
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::SelectColumnNames (const std::vector<std::string>& columnNames) noexcept
 	{
-		std::string nextLine;
-		bool readValid = m_fileObject.ReadNextLine (nextLine);
-		nextLine.erase (std::remove_if (nextLine.begin (), nextLine.end (), isspace), nextLine.end ());
+		std::vector<uint32_t> columns;
+
+		for (const std::string& columnName : columnNames)
+		{
+			uint32_t index = 0;
+			while (index < m_columnCollection.Length () && m_columnCollection[index].GetName () != columnName) ++index;
+
+			if (index == m_columnCollection.Length ())
+			{
+				spdlog::error ("Failed to select CSV column {0} which is not in the collection", columnName);
+				return false;
+			}
+
+			columns.push_back (index);
+		}
+
+		return SelectColumns (columns);
+	}
 
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::ReadLine () noexcept
+	{
+		bool readValid = ReadFields ();
 		m_columnCollection.ClearAll ();
-		uint32_t lastOffset = 0;
 
-		for (uint32_t index = 0; index < m_columnCollection.Length () && lastOffset < nextLine.length (); ++index)
+		for (uint32_t index = 0; index < m_columnCollection.Length () && index < m_fields.size (); ++index)
+		{
+			if (!IsSelected (index)) continue;
+
+			// The collection keeps the original behaviour of dropping all whitespace
+			m_fieldText.assign (m_fields[index]);
+			m_fieldText.erase (std::remove_if (m_fieldText.begin (), m_fieldText.end (), isspace), m_fieldText.end ());
+			SetFormattedAt (index, m_fieldText);
+		}
+
+		return readValid;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::ReadFields () noexcept
+	{
+		if (m_mappedFile.IsOpen ()) return ReadMappedFields ();
+
+		// The line buffer keeps its capacity so only the first few lines allocate
+		bool readValid = m_fileObject.ReadNextLine (m_lineBuffer);
+		const std::string_view nextLine = m_lineBuffer;
+
+		m_fields.clear ();
+		if (nextLine.empty ()) return readValid;
+
+		// Only the padding around each field is removed, unlike ReadLine
+		// spaces inside a string field are kept
+		size_t lastOffset = 0;
+
+		while (true)
 		{
 			size_t nextOffset = nextLine.find (Comma, lastOffset);
 
-			if (nextOffset == std::string::npos)
+			if (nextOffset == std::string_view::npos)
 			{
-				nextOffset = nextLine.length ();
+				AddField (nextLine.substr (lastOffset));
+				break;
 			}
 
-			SetFormattedAt (index, nextLine.substr (lastOffset, nextOffset - lastOffset));
+			AddField (nextLine.substr (lastOffset, nextOffset - lastOffset));
+			if (IsLineComplete ()) break;
+
 			lastOffset = nextOffset + 1;
 		}
 
 		return readValid;
 	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Walks the delimiter index rather than searching each field, as with
+	/// MappedFile::ReadNextLine empty lines are skipped and a final
+	/// unterminated line is returned as false
+
+	bool CSVReader::ReadMappedFields () noexcept
+	{
+		const std::string_view text = m_mappedFile.GetText ();
+		size_t offset = m_mappedFile.GetOffset ();
+
+		m_fields.clear ();
+
+		while (offset < text.length ())
+		{
+			size_t delimiter = NextDelimiter (offset);
+
+			if (delimiter < text.length () && text[delimiter] == Comma)
+			{
+				// Past the selected columns only the end of the line is wanted
+				if (!IsLineComplete ()) AddField (text.substr (offset, delimiter - offset));
+				offset = delimiter + 1;
+				continue;
+			}
+
+			if (m_fields.empty () && delimiter == offset)
+			{
+				++offset;
+				continue;
+			}
+
+			if (!IsLineComplete ()) AddField (text.substr (offset, delimiter - offset));
+			m_mappedFile.SetOffset (delimiter + 1);
+			return delimiter < text.length ();
+		}
+
+		// A trailing comma at the very end of the mapping still ends a field
+		if (!m_fields.empty () && !IsLineComplete ()) AddField (std::string_view ());
+
+		m_mappedFile.SetOffset (offset);
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Returns the offset of the first delimiter at or after the offset, or the
+	/// mapping size if there are none. The index covers a window of the
+	/// mapping which is rescanned as reading moves past it.
+
+	size_t CSVReader::NextDelimiter (size_t offset) noexcept
+	{
+		const std::string_view text = m_mappedFile.GetText ();
+
+		while (true)
+		{
+			if (offset >= m_scanStart && offset < m_scanEnd)
+			{
+				// After a seek backwards the position has to be found again
+				if (m_delimiterIndex > 0 && m_scanStart + m_delimiters[m_delimiterIndex - 1] >= offset)
+				{
+					auto nextDelimiter = std::lower_bound (m_delimiters.begin (), m_delimiters.end (), static_cast<uint32_t>(offset - m_scanStart));
+					m_delimiterIndex = static_cast<size_t>(nextDelimiter - m_delimiters.begin ());
+				}
+
+				while (m_delimiterIndex < m_delimiters.size () && m_scanStart + m_delimiters[m_delimiterIndex] < offset)
+				{
+					++m_delimiterIndex;
+				}
+
+				if (m_delimiterIndex < m_delimiters.size ()) return m_scanStart + m_delimiters[m_delimiterIndex];
+				offset = m_scanEnd;
+			}
+
+			if (offset >= text.length ()) return text.length ();
+
+			m_scanStart = offset;
+			m_scanEnd = std::min (text.length (), offset + ScanWindowSize);
+			m_delimiterIndex = 0;
+			m_delimiters.clear ();
+			CSVScanner::FindDelimiters (text.substr (m_scanStart, m_scanEnd - m_scanStart), m_delimiters);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVReader::ResetScan () noexcept
+	{
+		m_delimiters.clear ();
+		m_scanStart = 0;
+		m_scanEnd = 0;
+		m_delimiterIndex = 0;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVReader::LoadIndex () noexcept
+	{
+		if (m_indexLoaded) return;
+
+		(void)m_index.Load (m_filePath, GetFileSize ());
+		m_indexLoaded = true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	off_t CSVReader::GetFileSize () noexcept
+	{
+		struct stat fileStatus {};
+
+		if (m_fileObject.IsOpen () && fstat (m_fileObject.GetHandle (), &fileStatus) == 0)
+		{
+			return fileStatus.st_size;
+		}
+
+		return static_cast<off_t>(m_mappedFile.GetSize ());
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::SeekToOffset (off_t offset) noexcept
+	{
+		if (m_mappedFile.IsOpen ())
+		{
+			m_mappedFile.SetOffset (static_cast<size_t>(offset));
+			return true;
+		}
+
+		return m_fileObject.Seek (offset);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	off_t CSVReader::GetReadOffset () noexcept
+	{
+		if (m_mappedFile.IsOpen ()) return static_cast<off_t>(m_mappedFile.GetOffset ());
+		return m_fileObject.Tell ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::SkipLine () noexcept
+	{
+		if (m_mappedFile.IsOpen ())
+		{
+			std::string_view nextLine;
+			return m_mappedFile.ReadNextLine (nextLine);
+		}
+
+		return m_fileObject.ReadNextLine (m_lineBuffer);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVReader::FindTimeColumns (uint32_t& dateColumn, uint32_t& timeColumn) noexcept
+	{
+		bool hasDate = false;
+		bool hasTime = false;
+
+		for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
+		{
+			CSVColumn::Type type = m_columnCollection[index].GetType ();
+
+			if (type == CSVColumn::Type::Date && !hasDate)
+			{
+				dateColumn = index;
+				hasDate = true;
+			}
+			else if (type == CSVColumn::Type::Time && !hasTime)
+			{
+				timeColumn = index;
+				hasTime = true;
+			}
+		}
+
+		return hasDate && hasTime;
+	}
 }
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVIndex.h"
+#include "MappedFile.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVIndex::Load (const std::string& filePath, off_t fileSize) noexcept
+	{
+		bool complete = false;
+		return LoadEntries (filePath, fileSize, complete);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVIndex::OpenForWriting (const std::string& filePath, off_t fileSize) noexcept
+	{
+		Close ();
+
+		const std::string indexPath = GetIndexPath (filePath);
+		bool complete = false;
+
+		if (LoadEntries (filePath, fileSize, complete) && complete)
+		{
+			return m_fileObject.Open (indexPath, true);
+		}
+
+		return Rewrite (indexPath);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVIndex::Append (const Entry& entry) noexcept
+	{
+		if (!m_fileObject.IsOpen ()) return false;
+
+		try
+		{
+			m_entries.push_back (entry);
+		}
+		catch (const std::exception& exception)
+		{
+			spdlog::error ("Unable to add CSV index entry {0}", exception.what ());
+			return false;
+		}
+
+		return m_fileObject.Write (reinterpret_cast<const uint8_t*>(&entry), sizeof (entry));
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVIndex::Close () noexcept
+	{
+		m_fileObject.Close ();
+		m_entries.clear ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	const CSVIndex::Entry* CSVIndex::FindRow (uint64_t row) const noexcept
+	{
+		auto nextEntry = std::partition_point (m_entries.begin (), m_entries.end (), [row](const Entry& entry) { return entry.m_row <= row; });
+		return (nextEntry == m_entries.begin ()) ? nullptr : &*(nextEntry - 1);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	const CSVIndex::Entry* CSVIndex::FindTime (time_t time) const noexcept
+	{
+		auto nextEntry = std::partition_point (m_entries.begin (), m_entries.end (), [time](const Entry& entry) { return entry.m_time < time; });
+		return (nextEntry == m_entries.begin ()) ? nullptr : &*(nextEntry - 1);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Complete is only set if every entry in the index was kept, otherwise
+	/// the index was cut short or the CSV file has since been replaced
+
+	bool CSVIndex::LoadEntries (const std::string& filePath, off_t fileSize, bool& complete) noexcept
+	{
+		const std::string indexPath = GetIndexPath (filePath);
+		struct stat indexStatus {};
+
+		m_entries.clear ();
+		complete = false;
+
+		// Not having an index is normal so is not reported
+		if (stat (indexPath.c_str (), &indexStatus) != 0) return false;
+
+		MappedFile mappedFile;
+		if (!mappedFile.Open (indexPath, MappedFile::Access::Sequential)) return false;
+
+		std::span<const uint8_t> data = mappedFile.GetData ();
+		Header header {};
+
+		if (data.size () >= sizeof (header)) std::memcpy (&header, data.data (), sizeof (header));
+
+		if (std::memcmp (header.m_magic, Magic, sizeof (Magic)) != 0 || header.m_version != Version || header.m_entrySize != sizeof (Entry))
+		{
+			spdlog::warn ("Ignoring CSV index {0} as it is not valid", indexPath);
+			return false;
+		}
+
+		size_t entryCount = (data.size () - sizeof (header)) / sizeof (Entry);
+
+		try
+		{
+			m_entries.resize (entryCount);
+		}
+		catch (const std::exception& exception)
+		{
+			spdlog::error ("Unable to load CSV index {0} {1}", indexPath, exception.what ());
+			return false;
+		}
+
+		std::memcpy (m_entries.data (), data.data () + sizeof (header), entryCount * sizeof (Entry));
+
+		while (!m_entries.empty () && m_entries.back ().m_offset >= fileSize) m_entries.pop_back ();
+
+		complete = (m_entries.size () == entryCount) && (data.size () == sizeof (header) + (entryCount * sizeof (Entry)));
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVIndex::Rewrite (const std::string& indexPath) noexcept
+	{
+		Header header {};
+
+		std::memcpy (header.m_magic, Magic, sizeof (Magic));
+		header.m_version = Version;
+		header.m_entrySize = sizeof (Entry);
+
+		if (!m_fileObject.Create (indexPath)) return false;
+		if (!m_fileObject.Write (reinterpret_cast<const uint8_t*>(&header), sizeof (header))) return false;
+
+		if (!m_entries.empty ())
+		{
+			return m_fileObject.Write (reinterpret_cast<const uint8_t*>(m_entries.data ()), m_entries.size () * sizeof (Entry));
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,299 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVMerger.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVMerger::CSVMerger (CSVColumnCollection& columnCollection) noexcept :
+		m_columnCollection (columnCollection),
+		m_skippedRows (0),
+		m_dateColumn (0),
+		m_timeColumn (0),
+		m_hasHeader (false)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Each input reads into its own copy of the column collection. An empty
+	/// file is kept as an input with no rows.
+
+	bool CSVMerger::AddInput (const std::string& filePath, bool hasHeader) noexcept
+	{
+		if (!FindTimeColumns ())
+		{
+			spdlog::error ("Failed to add {0} to the merge as there is no Date and Time column", filePath);
+			return false;
+		}
+
+		try
+		{
+			Input input;
+			input.pColumnCollection = std::make_unique<CSVColumnCollection> ();
+			*input.pColumnCollection = m_columnCollection;
+			input.pReader = std::make_unique<CSVReader> (*input.pColumnCollection);
+
+			if (!input.pReader->OpenMapped (filePath)) return false;
+			if (hasHeader) (void)input.pReader->ReadHeader ();
+
+			input.readValid = true;
+			m_inputs.push_back (std::move (input));
+
+			if (m_inputs.size () == 1) m_hasHeader = hasHeader;
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to add {0} to the merge with error {1}", filePath, e.what ());
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVMerger::Close () noexcept
+	{
+		m_inputs.clear ();
+		m_skippedRows = 0;
+		m_hasHeader = false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// The heap holds the next row of every input that has one, the earliest
+	/// is handed out and replaced by the following row from the same input
+
+	bool CSVMerger::Merge (const RowHandler& handler) noexcept
+	{
+		try
+		{
+			std::vector<HeapEntry> heap;
+			heap.reserve (m_inputs.size ());
+
+			for (size_t index = 0; index < m_inputs.size (); ++index)
+			{
+				if (NextRow (m_inputs[index])) heap.push_back ({m_inputs[index].rowTime, m_inputs[index].rowNanoseconds, index});
+			}
+
+			std::make_heap (heap.begin (), heap.end ());
+
+			while (!heap.empty ())
+			{
+				std::pop_heap (heap.begin (), heap.end ());
+
+				HeapEntry& entry = heap.back ();
+				Input& input = m_inputs[entry.input];
+
+				if (!handler (*input.pReader, entry.input, input.rowTime)) return true;
+
+				if (NextRow (input))
+				{
+					entry.rowTime = input.rowTime;
+					entry.rowNanoseconds = input.rowNanoseconds;
+					std::push_heap (heap.begin (), heap.end ());
+				}
+				else
+				{
+					heap.pop_back ();
+				}
+			}
+
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to merge CSV files with error {0}", e.what ());
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVMerger::Merge (const std::string& filePath) noexcept
+	{
+		ASCIIFileObject fileObject;
+
+		if (!fileObject.Create (filePath)) return false;
+		fileObject.SetWriteBuffer (WriteBufferSize);
+
+		bool written = !m_hasHeader || WriteHeader (fileObject);
+
+		if (written)
+		{
+			bool merged = Merge ([&] (const CSVReader& reader, size_t, time_t)
+			{
+				written = WriteRow (fileObject, reader);
+				return written;
+			});
+
+			written = merged && written;
+		}
+
+		written = fileObject.Flush () && written;
+		fileObject.Close ();
+
+		return written;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVMerger::FindTimeColumns () noexcept
+	{
+		bool hasDate = false;
+		bool hasTime = false;
+
+		for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
+		{
+			CSVColumn::Type type = m_columnCollection[index].GetType ();
+
+			if (type == CSVColumn::Type::Date && !hasDate)
+			{
+				m_dateColumn = index;
+				hasDate = true;
+			}
+			else if (type == CSVColumn::Type::Time && !hasTime)
+			{
+				m_timeColumn = index;
+				hasTime = true;
+			}
+		}
+
+		return hasDate && hasTime;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Reads the input on to its next row with a valid time, as with
+	/// ReadFields a final unterminated line is still a row
+
+	bool CSVMerger::NextRow (Input& input) noexcept
+	{
+		CSVReader& reader = *input.pReader;
+
+		while (input.readValid)
+		{
+			input.readValid = reader.ReadFields ();
+			if (reader.GetFieldCount () == 0) continue;
+
+			if (input.timeParser.ParseTimestamp (reader.GetField (m_dateColumn), reader.GetField (m_timeColumn), input.rowTime))
+			{
+				input.rowNanoseconds = ParseNanoseconds (reader.GetField (m_timeColumn));
+				return true;
+			}
+
+			++m_skippedRows;
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// The fraction after "HH:MM:SS." scaled to nanoseconds, zero if none
+
+	uint32_t CSVMerger::ParseNanoseconds (std::string_view time) noexcept
+	{
+		uint32_t nanoseconds = 0;
+		uint32_t scale = 1000000000;
+
+		time = CSVFormat::Trim (time);
+		if (time.length () <= 9 || time[8] != '.') return 0;
+
+		for (char digit : time.substr (9, 9))
+		{
+			if (digit < '0' || digit > '9') return 0;
+
+			scale /= 10;
+			nanoseconds += static_cast<uint32_t>(digit - '0') * scale;
+		}
+
+		return nanoseconds;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Fields are written as CSVWriter writes them
+
+	bool CSVMerger::WriteRow (ASCIIFileObject& fileObject, const CSVReader& reader) noexcept
+	{
+		try
+		{
+			m_lineText.clear ();
+
+			for (size_t index = 0; index < reader.GetFieldCount (); ++index)
+			{
+				if (index != 0) m_lineText.append (", ");
+				m_lineText.append (reader.GetField (index));
+			}
+
+			m_lineText.append ("\r\n");
+			return fileObject.WriteString (m_lineText);
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to write a merged row with error {0}", e.what ());
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVMerger::WriteHeader (ASCIIFileObject& fileObject) noexcept
+	{
+		if (m_inputs.empty ()) return true;
+
+		try
+		{
+			CSVColumnCollection& columnCollection = *m_inputs.front ().pColumnCollection;
+			m_lineText.clear ();
+
+			for (uint32_t index = 0; index < columnCollection.Length (); ++index)
+			{
+				if (index != 0) m_lineText.append (", ");
+				m_lineText.append (columnCollection[index].GetName ());
+			}
+
+			m_lineText.append ("\r\n");
+			return fileObject.WriteString (m_lineText);
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to write the merged header with error {0}", e.what ());
+		}
+
+		return false;
+	}
+}
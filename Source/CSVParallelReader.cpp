@@ -0,0 +1,289 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVParallelReader.h"
+#include "CSVScanner.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// Walks the delimiter index in the same way as CSVReader::ReadFields,
+	/// empty lines are skipped and each field has its padding trimmed
+
+	void CSVChunk::Parse (std::string_view text, size_t columns, std::vector<uint32_t>& delimiters)
+	{
+		m_columns = columns;
+		m_rowCount = 0;
+		m_fields.clear ();
+
+		delimiters.clear ();
+		CSVScanner::FindDelimiters (text, delimiters);
+
+		// Acts as a line end for a final unterminated line
+		delimiters.push_back (static_cast<uint32_t>(text.length ()));
+
+		// Every field ends at a delimiter, so this is close to the final size
+		m_fields.reserve (delimiters.size ());
+
+		size_t fieldStart = 0;
+		size_t column = 0;
+
+		for (uint32_t delimiter : delimiters)
+		{
+			bool lineEnd = (delimiter == text.length ()) || (text[delimiter] != ',');
+
+			if (lineEnd && column == 0 && delimiter == fieldStart)
+			{
+				fieldStart = delimiter + 1;
+				continue;
+			}
+
+			if (column < columns) m_fields.push_back (CSVFormat::Trim (text.substr (fieldStart, delimiter - fieldStart)));
+			++column;
+			fieldStart = delimiter + 1;
+
+			if (lineEnd)
+			{
+				for (; column < columns; ++column) m_fields.push_back (std::string_view ());
+
+				column = 0;
+				++m_rowCount;
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVParallelReader::CSVParallelReader (CSVColumnCollection& columnCollection) noexcept :
+		m_columnCollection (columnCollection),
+		m_dataOffset (0)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVParallelReader::Open (const std::string& filePath, bool hasHeader) noexcept
+	{
+		m_boundaries.clear ();
+		m_dataOffset = 0;
+
+		if (!m_mappedFile.Open (filePath, MappedFile::Access::WillNeed)) return false;
+
+		if (hasHeader)
+		{
+			std::string_view header;
+			(void)m_mappedFile.ReadNextLine (header);
+			m_dataOffset = m_mappedFile.GetOffset ();
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVParallelReader::Close () noexcept
+	{
+		m_mappedFile.Close ();
+		m_boundaries.clear ();
+		m_dataOffset = 0;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVColumn::Type CSVParallelReader::GetType (uint8_t column) noexcept
+	{
+		if (column >= m_columnCollection.Columns ()) return CSVColumn::Type::String;
+		return m_columnCollection.GetAt (column).GetType ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVParallelReader::Load (std::vector<CSVChunk>& chunks, uint32_t threadCount) noexcept
+	{
+		chunks.clear ();
+
+		if (!m_mappedFile.IsOpen () || m_columnCollection.Columns () == 0)
+		{
+			spdlog::error ("Unable to load CSV without an open file and columns");
+			return false;
+		}
+
+		threadCount = (threadCount == 0) ? std::max (std::thread::hardware_concurrency (), 1U) : threadCount;
+		if (!SplitChunks (threadCount)) return false;
+
+		try
+		{
+			chunks.resize (m_boundaries.size () - 1);
+		}
+		catch (const std::exception& exception)
+		{
+			spdlog::error ("Unable to allocate CSV chunks {0}", exception.what ());
+			return false;
+		}
+
+		// Each chunk is only ever touched by the worker that parses it
+		return RunWorkers (threadCount, [this, &chunks](uint32_t index) { ParseChunk (index, chunks[index]); });
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVParallelReader::Load (const ChunkConsumer& consumer, uint32_t threadCount) noexcept
+	{
+		if (!m_mappedFile.IsOpen () || m_columnCollection.Columns () == 0)
+		{
+			spdlog::error ("Unable to load CSV without an open file and columns");
+			return false;
+		}
+
+		threadCount = (threadCount == 0) ? std::max (std::thread::hardware_concurrency (), 1U) : threadCount;
+		if (!SplitChunks (threadCount)) return false;
+
+		return RunWorkers (threadCount, [this, &consumer](uint32_t index)
+		{
+			// A worker could reuse its chunk, but then a consumer could not keep it
+			CSVChunk chunk;
+			ParseChunk (index, chunk);
+			consumer (chunk);
+		});
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Splits the data into ranges that each end just after a line feed, there
+	/// are a few more ranges than threads so uneven ranges balance out
+
+	bool CSVParallelReader::SplitChunks (uint32_t threadCount) noexcept
+	{
+		const std::string_view text = m_mappedFile.GetText ();
+		const size_t dataSize = text.length () - m_dataOffset;
+		size_t chunkSize = std::clamp (dataSize / (static_cast<size_t>(threadCount) * ChunksPerThread), MinimumChunkSize, MaximumChunkSize);
+
+		m_boundaries.clear ();
+
+		try
+		{
+			m_boundaries.reserve (dataSize / chunkSize + 2);
+		}
+		catch (const std::exception& exception)
+		{
+			spdlog::error ("Unable to allocate CSV chunks {0}", exception.what ());
+			return false;
+		}
+
+		m_boundaries.push_back (m_dataOffset);
+
+		while (m_boundaries.back () < text.length ())
+		{
+			size_t boundary = m_boundaries.back () + chunkSize;
+
+			if (boundary >= text.length ())
+			{
+				boundary = text.length ();
+			}
+			else
+			{
+				boundary = text.find ('\n', boundary);
+				boundary = (boundary == std::string_view::npos) ? text.length () : boundary + 1;
+			}
+
+			m_boundaries.push_back (boundary);
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVParallelReader::ParseChunk (uint32_t index, CSVChunk& chunk)
+	{
+		// The delimiter index is per thread so it is allocated once per worker
+		thread_local std::vector<uint32_t> delimiters;
+
+		const std::string_view text = m_mappedFile.GetText ();
+
+		chunk.m_index = index;
+		chunk.m_offset = m_boundaries[index];
+		chunk.Parse (text.substr (m_boundaries[index], m_boundaries[index + 1] - m_boundaries[index]), m_columnCollection.Columns (), delimiters);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Workers take the next unparsed chunk until there are none left, the
+	/// calling thread works as well so a failure to start threads only slows
+	/// the load down
+
+	bool CSVParallelReader::RunWorkers (uint32_t threadCount, const std::function<void (uint32_t index)>& work) noexcept
+	{
+		const uint32_t chunkCount = static_cast<uint32_t>(m_boundaries.size () - 1);
+		std::atomic<uint32_t> nextChunk (0);
+		std::atomic<bool> failed (false);
+
+		auto worker = [&]()
+		{
+			try
+			{
+				for (uint32_t index = nextChunk++; index < chunkCount; index = nextChunk++) work (index);
+			}
+			catch (const std::exception& exception)
+			{
+				spdlog::error ("CSV chunk load failed {0}", exception.what ());
+				failed = true;
+				nextChunk = chunkCount;
+			}
+		};
+
+		std::vector<std::thread> threads;
+
+		try
+		{
+			uint32_t extraThreads = std::min (threadCount, chunkCount);
+			threads.reserve (extraThreads);
+
+			for (uint32_t thread = 1; thread < extraThreads; ++thread) threads.emplace_back (worker);
+		}
+		catch (const std::exception& exception)
+		{
+			spdlog::error ("Unable to start CSV load thread {0}", exception.what ());
+		}
+
+		worker ();
+
+		for (std::thread& thread : threads) thread.join ();
+
+		return !failed;
+	}
+}
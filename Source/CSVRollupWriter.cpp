@@ -0,0 +1,289 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVRollupWriter.h"
+#include "CSVFormat.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVRollupWriter::CSVRollupWriter (CSVColumnCollection& columnCollection) :
+		m_columnCollection (columnCollection),
+		m_writer (m_rollupCollection),
+		m_periodStart (0),
+		m_periodSeconds (0),
+		m_periodRows (0),
+		m_rowCount (0),
+		m_rowsWritten (0)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVRollupWriter::~CSVRollupWriter ()
+	{
+		Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVRollupWriter::AddRollup (uint32_t column, CSVRollup rollup) noexcept
+	{
+		if (column >= m_columnCollection.Length ())
+		{
+			spdlog::error ("Failed to add a rollup of column {0} which is not in the collection", column);
+			return false;
+		}
+
+		try
+		{
+			Rollup& added = m_rollups.emplace_back ();
+			added.column = column;
+			added.rollup = rollup;
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to add a rollup with error {0}", e.what ());
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// A new file gets a header, an appended one is assumed to have one
+
+	bool CSVRollupWriter::Open (const std::string& filePath, bool append) noexcept
+	{
+		Close ();
+
+		try
+		{
+			AddOutputColumns ();
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to set up the rollup columns for {0} with error {1}", filePath, e.what ());
+			return false;
+		}
+
+		if (m_periodSeconds == 0 && m_periodRows == 0) m_periodSeconds = DefaultPeriodSeconds;
+
+		m_rowCount = 0;
+		m_rowsWritten = 0;
+
+		if (!m_writer.Open (filePath, append)) return false;
+		return append || m_writer.WriteHeader ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVRollupWriter::Close () noexcept
+	{
+		(void)WriteRollups ();
+		m_writer.Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVRollupWriter::Add () noexcept
+	{
+		timespec now {};
+		clock_gettime (CLOCK_REALTIME, &now);
+		return Add (now);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// A row in a later period first writes out the one before
+
+	bool CSVRollupWriter::Add (const timespec& rowTime) noexcept
+	{
+		if (m_periodSeconds > 0)
+		{
+			time_t periodStart = rowTime.tv_sec - (rowTime.tv_sec % m_periodSeconds);
+
+			if (m_rowCount > 0 && periodStart != m_periodStart && !WriteRollups ()) return false;
+			if (m_rowCount == 0) m_periodStart = periodStart;
+		}
+		else if (m_rowCount == 0)
+		{
+			m_periodStart = rowTime.tv_sec;
+		}
+
+		try
+		{
+			for (Rollup& rollup : m_rollups)
+			{
+				const std::string& text = m_columnCollection[rollup.column].GetValueAsText ();
+				double value = 0.0;
+
+				if (rollup.rollup == CSVRollup::Last)
+				{
+					rollup.lastText.assign (text);
+				}
+				else if (CSVFormat::Parse (text, value) && std::isfinite (value))
+				{
+					rollup.minimum = (rollup.count == 0) ? value : std::min (rollup.minimum, value);
+					rollup.maximum = (rollup.count == 0) ? value : std::max (rollup.maximum, value);
+					rollup.sum += value;
+					++rollup.count;
+				}
+			}
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to add a row to the rollups with error {0}", e.what ());
+			return false;
+		}
+
+		++m_rowCount;
+
+		if (m_periodRows > 0 && m_rowCount >= m_periodRows) return WriteRollups ();
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVRollupWriter::Flush () noexcept
+	{
+		return WriteRollups () && m_writer.Flush ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Ints are rounded back to whole numbers, a column with no values in the
+	/// period is left empty
+
+	bool CSVRollupWriter::WriteRollups () noexcept
+	{
+		if (m_rowCount == 0) return true;
+
+		for (Rollup& rollup : m_rollups)
+		{
+			CSVColumn& column = m_rollupCollection[rollup.outputColumn];
+			double value = 0.0;
+
+			if (rollup.rollup == CSVRollup::Last)
+			{
+				column.SetFormattedText (rollup.lastText);
+				continue;
+			}
+
+			if (rollup.count == 0)
+			{
+				column.Clear ();
+				continue;
+			}
+
+			switch (rollup.rollup)
+			{
+			case	CSVRollup::Minimum:	value = rollup.minimum;	break;
+			case	CSVRollup::Maximum:	value = rollup.maximum;	break;
+			default:					value = rollup.sum / static_cast<double>(rollup.count); break;
+			}
+
+			if (column.GetType () == CSVColumn::Type::Int)
+			{
+				column.Format (static_cast<int32_t>(std::llround (value)));
+			}
+			else
+			{
+				column.Format (static_cast<float>(value));
+			}
+		}
+
+		bool written = m_writer.WriteLine (timespec {m_periodStart, 0});
+
+		for (Rollup& rollup : m_rollups)
+		{
+			rollup.count = 0;
+			rollup.sum = 0.0;
+			rollup.lastText.clear ();
+		}
+
+		m_rowCount = 0;
+		if (written) ++m_rowsWritten;
+
+		return written;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVRollupWriter::AddOutputColumns ()
+	{
+		static constexpr std::string_view Suffixes[] = {"_min", "_max", "_mean", ""};
+
+		if (m_rollups.empty ())
+		{
+			for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
+			{
+				CSVColumn::Type type = m_columnCollection[index].GetType ();
+
+				if (type == CSVColumn::Type::Int || type == CSVColumn::Type::Float) (void)AddRollup (index, CSVRollup::Mean);
+				else if (type == CSVColumn::Type::String) (void)AddRollup (index, CSVRollup::Last);
+			}
+		}
+
+		CSVColumnCollection rollupCollection;
+
+		for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
+		{
+			const CSVColumn& column = m_columnCollection[index];
+			CSVColumn::Type type = column.GetType ();
+
+			if (type == CSVColumn::Type::Row || type == CSVColumn::Type::Date || type == CSVColumn::Type::Time)
+			{
+				rollupCollection.AddColumn (column);
+				continue;
+			}
+
+			for (Rollup& rollup : m_rollups)
+			{
+				if (rollup.column != index) continue;
+
+				CSVColumn outputColumn (column);
+				outputColumn.SetName (column.GetName () + std::string (Suffixes[static_cast<size_t>(rollup.rollup)]));
+
+				rollup.outputColumn = rollupCollection.Length ();
+				rollupCollection.AddColumn (outputColumn);
+			}
+		}
+
+		m_rollupCollection = rollupCollection;
+	}
+}
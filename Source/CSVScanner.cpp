@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVScanner.h"
+
+#include <bit>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>
+#define CSV_SCANNER_X86
+#elif defined (__ARM_NEON)
+#include <arm_neon.h>
+#define CSV_SCANNER_NEON
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// Each implementation returns a mask with one bit set per delimiter in a
+	/// 64 byte block, bit n corresponding to byte n
+
+	namespace
+	{
+		inline bool IsDelimiter (char character) noexcept
+		{
+			return character == ',' || character == '\r' || character == '\n';
+		}
+
+		inline void AddOffsets (uint64_t mask, uint32_t base, std::vector<uint32_t>& offsets)
+		{
+			while (mask != 0)
+			{
+				offsets.push_back (base + static_cast<uint32_t>(std::countr_zero (mask)));
+				mask &= mask - 1;
+			}
+		}
+
+		[[maybe_unused]] uint64_t ScalarMask (const char* pBlock) noexcept
+		{
+			uint64_t mask = 0;
+
+			for (size_t index = 0; index < CSVScanner::BlockSize; ++index)
+			{
+				mask |= static_cast<uint64_t>(IsDelimiter (pBlock[index])) << index;
+			}
+
+			return mask;
+		}
+
+#ifdef CSV_SCANNER_X86
+		uint64_t SSE2Mask (const char* pBlock) noexcept
+		{
+			const __m128i comma = _mm_set1_epi8 (',');
+			const __m128i carriageReturn = _mm_set1_epi8 ('\r');
+			const __m128i lineFeed = _mm_set1_epi8 ('\n');
+			uint64_t mask = 0;
+
+			for (size_t index = 0; index < CSVScanner::BlockSize; index += 16)
+			{
+				__m128i chunk = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(pBlock + index));
+				__m128i found = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (chunk, comma), _mm_cmpeq_epi8 (chunk, carriageReturn)), _mm_cmpeq_epi8 (chunk, lineFeed));
+				mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8 (found))) << index;
+			}
+
+			return mask;
+		}
+
+		__attribute__ ((target ("avx2"))) uint64_t AVX2Mask (const char* pBlock) noexcept
+		{
+			const __m256i comma = _mm256_set1_epi8 (',');
+			const __m256i carriageReturn = _mm256_set1_epi8 ('\r');
+			const __m256i lineFeed = _mm256_set1_epi8 ('\n');
+
+			__m256i low = _mm256_loadu_si256 (reinterpret_cast<const __m256i*>(pBlock));
+			__m256i high = _mm256_loadu_si256 (reinterpret_cast<const __m256i*>(pBlock + 32));
+			__m256i foundLow = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (low, comma), _mm256_cmpeq_epi8 (low, carriageReturn)), _mm256_cmpeq_epi8 (low, lineFeed));
+			__m256i foundHigh = _mm256_or_si256 (_mm256_or_si256 (_mm256_cmpeq_epi8 (high, comma), _mm256_cmpeq_epi8 (high, carriageReturn)), _mm256_cmpeq_epi8 (high, lineFeed));
+
+			return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8 (foundLow))) |
+				(static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8 (foundHigh))) << 32);
+		}
+
+		// Checked once, the block loop then calls through a plain function pointer
+		using MaskFunction = uint64_t (*) (const char*) noexcept;
+		const bool HasAVX2 = __builtin_cpu_supports ("avx2");
+		const MaskFunction BlockMask = HasAVX2 ? AVX2Mask : SSE2Mask;
+#elif defined (CSV_SCANNER_NEON)
+		uint64_t NEONMask (const char* pBlock) noexcept
+		{
+			const uint8x16_t comma = vdupq_n_u8 (',');
+			const uint8x16_t carriageReturn = vdupq_n_u8 ('\r');
+			const uint8x16_t lineFeed = vdupq_n_u8 ('\n');
+			uint64_t mask = 0;
+
+			for (size_t index = 0; index < CSVScanner::BlockSize; index += 16)
+			{
+				uint8x16_t chunk = vld1q_u8 (reinterpret_cast<const uint8_t*>(pBlock + index));
+				uint8x16_t found = vorrq_u8 (vorrq_u8 (vceqq_u8 (chunk, comma), vceqq_u8 (chunk, carriageReturn)), vceqq_u8 (chunk, lineFeed));
+
+				// NEON has no movemask, narrowing gives four bits per byte which
+				// are then reduced to one
+				uint64_t nibbles = vget_lane_u64 (vreinterpret_u64_u8 (vshrn_n_u16 (vreinterpretq_u16_u8 (found), 4)), 0) & 0x8888888888888888ULL;
+
+				for (; nibbles != 0; nibbles &= nibbles - 1)
+				{
+					mask |= 1ULL << (index + (std::countr_zero (nibbles) >> 2));
+				}
+			}
+
+			return mask;
+		}
+
+		inline uint64_t BlockMask (const char* pBlock) noexcept { return NEONMask (pBlock); }
+#else
+		inline uint64_t BlockMask (const char* pBlock) noexcept { return ScalarMask (pBlock); }
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t CSVScanner::FindDelimiters (std::string_view text, std::vector<uint32_t>& offsets) noexcept
+	{
+		const size_t initialCount = offsets.size ();
+		const char* pText = text.data ();
+		size_t offset = 0;
+
+		for (; offset + BlockSize <= text.length (); offset += BlockSize)
+		{
+			AddOffsets (BlockMask (pText + offset), static_cast<uint32_t>(offset), offsets);
+		}
+
+		for (; offset < text.length (); ++offset)
+		{
+			if (IsDelimiter (pText[offset])) offsets.push_back (static_cast<uint32_t>(offset));
+		}
+
+		return offsets.size () - initialCount;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	const char* CSVScanner::GetImplementation () noexcept
+	{
+#ifdef CSV_SCANNER_X86
+		return HasAVX2 ? "AVX2" : "SSE2";
+#elif defined (CSV_SCANNER_NEON)
+		return "NEON";
+#else
+		return "Scalar";
+#endif
+	}
+}
@@ -0,0 +1,316 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVStatistics.h"
+#include "CSVFile.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	/// Infinities and NANs would spoil every result so they are not counted
+
+	void CSVColumnStatistics::Add (double value)
+	{
+		if (!std::isfinite (value)) return;
+
+		++m_histogram[GetBucket (value)];
+
+		if (m_count++ == 0)
+		{
+			m_minimum = m_maximum = value;
+		}
+		else
+		{
+			m_minimum = std::min (m_minimum, value);
+			m_maximum = std::max (m_maximum, value);
+		}
+
+		double delta = value - m_mean;
+		m_mean += delta / static_cast<double>(m_count);
+		m_squares += delta * (value - m_mean);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Combines two summaries as if every value had been added to one, with
+	/// Chan's pairwise form of Welford's method
+
+	void CSVColumnStatistics::Merge (const CSVColumnStatistics& from)
+	{
+		if (from.m_count == 0) return;
+
+		if (m_count == 0)
+		{
+			*this = from;
+			return;
+		}
+
+		double count = static_cast<double>(m_count);
+		double fromCount = static_cast<double>(from.m_count);
+		double totalCount = count + fromCount;
+		double delta = from.m_mean - m_mean;
+
+		m_mean += delta * fromCount / totalCount;
+		m_squares += from.m_squares + (delta * delta * count * fromCount / totalCount);
+		m_minimum = std::min (m_minimum, from.m_minimum);
+		m_maximum = std::max (m_maximum, from.m_maximum);
+		m_count += from.m_count;
+
+		for (const auto& [bucket, bucketCount] : from.m_histogram) m_histogram[bucket] += bucketCount;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVColumnStatistics::Clear () noexcept
+	{
+		m_count = 0;
+		m_minimum = NAN;
+		m_maximum = NAN;
+		m_mean = 0.0;
+		m_squares = 0.0;
+		m_histogram.clear ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Nearest rank over the histogram, the bucket's centre is clamped to the
+	/// exact minimum and maximum so the ends are never overstated
+
+	double CSVColumnStatistics::GetPercentile (double percentile) const noexcept
+	{
+		if (m_count == 0) return NAN;
+
+		percentile = std::clamp (percentile, 0.0, 100.0);
+		uint64_t rank = static_cast<uint64_t>(std::llround (percentile / 100.0 * static_cast<double>(m_count - 1)));
+		uint64_t seen = 0;
+
+		for (const auto& [bucket, bucketCount] : m_histogram)
+		{
+			seen += bucketCount;
+			if (seen > rank) return std::clamp (GetBucketValue (bucket), m_minimum, m_maximum);
+		}
+
+		return m_maximum;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Buckets are numbered so they sort in the same order as their values,
+	/// negative values below zero and zero on its own
+
+	int32_t CSVColumnStatistics::GetBucket (double value) noexcept
+	{
+		if (std::fabs (value) < ZeroMagnitude) return 0;
+
+		int exponent = 0;
+		double mantissa = std::frexp (std::fabs (value), &exponent);
+		int32_t subBucket = std::min (static_cast<int32_t>((mantissa - 0.5) * 2.0 * SubBuckets), SubBuckets - 1);
+		int32_t bucket = ((exponent + ExponentBias) * SubBuckets) + subBucket + 1;
+
+		return (value < 0.0) ? -bucket : bucket;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	double CSVColumnStatistics::GetBucketValue (int32_t bucket) noexcept
+	{
+		if (bucket == 0) return 0.0;
+
+		int32_t magnitude = std::abs (bucket) - 1;
+		int exponent = (magnitude / SubBuckets) - ExponentBias;
+		double mantissa = 0.5 + ((static_cast<double>(magnitude % SubBuckets) + 0.5) / (2.0 * SubBuckets));
+		double value = std::ldexp (mantissa, exponent);
+
+		return (bucket < 0) ? -value : value;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVStatistics::CSVStatistics (CSVColumnCollection& columnCollection) noexcept :
+		m_columnCollection (columnCollection),
+		m_pGroup (nullptr),
+		m_groupTime (0),
+		m_timeBucket (CSVTimeBucket::All),
+		m_skippedRows (0),
+		m_dateColumn (-1),
+		m_timeColumn (-1),
+		m_prepared (false)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVStatistics::SetColumns (const std::vector<uint32_t>& columns) noexcept
+	{
+		try
+		{
+			Clear ();
+			m_columns = columns;
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to set CSV statistics columns with error {0}", e.what ());
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVStatistics::SetTimeBucket (CSVTimeBucket timeBucket) noexcept
+	{
+		Clear ();
+		m_timeBucket = timeBucket;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVStatistics::Clear () noexcept
+	{
+		m_groups.clear ();
+		m_pGroup = nullptr;
+		m_skippedRows = 0;
+		m_prepared = false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVStatistics::Add (const CSVReader& reader) noexcept
+	{
+		try
+		{
+			if (!m_prepared) Prepare ();
+
+			time_t groupTime = 0;
+
+			if (m_timeBucket != CSVTimeBucket::All && !GetGroupTime (reader, groupTime))
+			{
+				++m_skippedRows;
+				return true;
+			}
+
+			// Rows arrive in time order so the group rarely changes
+			if (m_pGroup == nullptr || groupTime != m_groupTime)
+			{
+				Group& group = m_groups[groupTime];
+				if (group.empty ()) group.resize (m_columns.size ());
+
+				m_pGroup = &group;
+				m_groupTime = groupTime;
+			}
+
+			for (size_t index = 0; index < m_columns.size (); ++index)
+			{
+				double value = 0.0;
+				if (CSVFormat::Parse (reader.GetField (m_columns[index]), value)) (*m_pGroup)[index].Add (value);
+			}
+
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			spdlog::error ("Failed to add a row to the CSV statistics with error {0}", e.what ());
+		}
+
+		return false;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVStatistics::Read (CSVReader& reader) noexcept
+	{
+		while (true)
+		{
+			bool readValid = reader.ReadFields ();
+
+			if (reader.GetFieldCount () > 0 && !Add (reader)) return false;
+			if (!readValid) return true;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Columns are looked up on first use so the collection can be filled in
+	/// after construction
+
+	void CSVStatistics::Prepare ()
+	{
+		m_dateColumn = -1;
+		m_timeColumn = -1;
+
+		for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
+		{
+			CSVColumn::Type type = m_columnCollection[index].GetType ();
+
+			if (type == CSVColumn::Type::Date && m_dateColumn < 0) m_dateColumn = static_cast<int32_t>(index);
+			if (type == CSVColumn::Type::Time && m_timeColumn < 0) m_timeColumn = static_cast<int32_t>(index);
+		}
+
+		if (m_columns.empty ())
+		{
+			for (uint32_t index = 0; index < m_columnCollection.Length (); ++index)
+			{
+				CSVColumn::Type type = m_columnCollection[index].GetType ();
+				if (type == CSVColumn::Type::Int || type == CSVColumn::Type::Float) m_columns.push_back (index);
+			}
+		}
+
+		if (m_timeBucket != CSVTimeBucket::All && (m_dateColumn < 0 || m_timeColumn < 0))
+		{
+			spdlog::warn ("Grouping CSV statistics by time needs a Date and a Time column");
+		}
+
+		m_prepared = true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Periods are counted from local midnight, using the elapsed time so
+	/// hours still line up on the days clocks change
+
+	bool CSVStatistics::GetGroupTime (const CSVReader& reader, time_t& groupTime) noexcept
+	{
+		time_t midnight = 0;
+		time_t rowTime = 0;
+
+		if (m_dateColumn < 0 || m_timeColumn < 0) return false;
+		if (!m_timeParser.ParseTimestamp (reader.GetField (m_dateColumn), reader.GetField (m_timeColumn), rowTime)) return false;
+		if (!m_timeParser.ParseDate (reader.GetField (m_dateColumn), midnight)) return false;
+
+		time_t period = static_cast<time_t>(m_timeBucket);
+		groupTime = (m_timeBucket == CSVTimeBucket::Day) ? midnight : midnight + (((rowTime - midnight) / period) * period);
+		return true;
+	}
+}
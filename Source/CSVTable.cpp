@@ -0,0 +1,405 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "CSVTable.h"
+#include "CSVFormat.h"
+#include "CSVParallelReader.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVTable::Column::Append (Column& from)
+	{
+		floats.insert (floats.end (), from.floats.begin (), from.floats.end ());
+		integers.insert (integers.end (), from.integers.begin (), from.integers.end ());
+		times.insert (times.end (), from.times.begin (), from.times.end ());
+
+		size_t textOffset = text.length ();
+		text.append (from.text);
+		for (size_t textEnd : from.textEnds) textEnds.push_back (textOffset + textEnd);
+
+		// The partial is finished with, so release its memory straight away
+		CSVColumn::Type type = from.type;
+		from = Column ();
+		from.type = type;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVTable::CSVTable (CSVColumnCollection& columnCollection) noexcept :
+		m_columnCollection (columnCollection),
+		m_rowCount (0),
+		m_dateColumn (-1),
+		m_timeColumn (-1)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool CSVTable::Load (const std::string& filePath, bool hasHeader, uint32_t threadCount) noexcept
+	{
+		Clear ();
+
+		CSVParallelReader reader (m_columnCollection);
+		if (!reader.Open (filePath, hasHeader)) return false;
+
+		try
+		{
+			for (uint32_t index = 0; index < m_columnCollection.Columns (); ++index)
+			{
+				CSVColumn::Type type = m_columnCollection.GetAt (index).GetType ();
+
+				m_columns.emplace_back ().type = type;
+				if (type == CSVColumn::Type::Date && m_dateColumn < 0) m_dateColumn = index;
+				if (type == CSVColumn::Type::Time && m_timeColumn < 0) m_timeColumn = index;
+			}
+
+			// Chunks are converted on the reader's threads and joined in file order
+			std::mutex partialMutex;
+			std::map<uint32_t, Partial> partials;
+
+			bool loaded = reader.Load ([this, &partialMutex, &partials](const CSVChunk& chunk)
+			{
+				Partial partial;
+				Convert (chunk, partial);
+
+				std::lock_guard<std::mutex> lock (partialMutex);
+				partials.emplace (chunk.GetIndex (), std::move (partial));
+			}, threadCount);
+
+			if (!loaded)
+			{
+				Clear ();
+				return false;
+			}
+
+			for (auto& [index, partial] : partials) Append (partial);
+		}
+		catch (const std::exception& exception)
+		{
+			spdlog::error ("Unable to load table from {0} {1}", filePath, exception.what ());
+			Clear ();
+			return false;
+		}
+
+		spdlog::info ("Loaded {0} rows from {1}", m_rowCount, filePath);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVTable::Clear () noexcept
+	{
+		m_columns.clear ();
+		m_timestamps.clear ();
+		m_rowCount = 0;
+		m_dateColumn = -1;
+		m_timeColumn = -1;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVColumn::Type CSVTable::GetType (size_t column) const noexcept
+	{
+		return (column < m_columns.size ()) ? m_columns[column].type : CSVColumn::Type::String;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	std::span<const float> CSVTable::GetFloats (size_t column) const noexcept
+	{
+		return (column < m_columns.size ()) ? std::span<const float> (m_columns[column].floats) : std::span<const float> ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	std::span<const int32_t> CSVTable::GetIntegers (size_t column) const noexcept
+	{
+		return (column < m_columns.size ()) ? std::span<const int32_t> (m_columns[column].integers) : std::span<const int32_t> ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	std::span<const time_t> CSVTable::GetTimes (size_t column) const noexcept
+	{
+		return (column < m_columns.size ()) ? std::span<const time_t> (m_columns[column].times) : std::span<const time_t> ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	std::string_view CSVTable::GetText (size_t column, size_t row) const noexcept
+	{
+		if (column >= m_columns.size () || row >= m_columns[column].textEnds.size ()) return {};
+
+		const Column& textColumn = m_columns[column];
+		size_t textStart = (row > 0) ? textColumn.textEnds[row - 1] : 0;
+		return std::string_view (textColumn.text).substr (textStart, textColumn.textEnds[row] - textStart);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVTable::SelectAll (std::vector<uint8_t>& selection) const
+	{
+		selection.assign (m_rowCount, 1);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// The loops are kept branch free so the compiler can vectorise them
+
+	void CSVTable::FilterRange (size_t column, double minimum, double maximum, std::vector<uint8_t>& selection) const noexcept
+	{
+		if (selection.size () != m_rowCount || column >= m_columns.size ()) return;
+
+		uint8_t* pSelection = selection.data ();
+
+		if (m_columns[column].type == CSVColumn::Type::Float)
+		{
+			const float* pValues = m_columns[column].floats.data ();
+			const float lower = static_cast<float>(minimum);
+			const float upper = static_cast<float>(maximum);
+
+			for (size_t row = 0; row < m_rowCount; ++row)
+			{
+				pSelection[row] &= static_cast<uint8_t>((pValues[row] >= lower) & (pValues[row] <= upper));
+			}
+		}
+		else if (!m_columns[column].integers.empty ())
+		{
+			const int32_t* pValues = m_columns[column].integers.data ();
+			const int64_t lower = static_cast<int64_t>(std::ceil (std::max (minimum, -2147483648.0)));
+			const int64_t upper = static_cast<int64_t>(std::floor (std::min (maximum, 2147483647.0)));
+
+			for (size_t row = 0; row < m_rowCount; ++row)
+			{
+				pSelection[row] &= static_cast<uint8_t>((pValues[row] >= lower) & (pValues[row] <= upper));
+			}
+		}
+		else if (!m_columns[column].times.empty ())
+		{
+			const time_t* pValues = m_columns[column].times.data ();
+			const time_t lower = static_cast<time_t>(std::ceil (minimum));
+			const time_t upper = static_cast<time_t>(std::floor (maximum));
+
+			for (size_t row = 0; row < m_rowCount; ++row)
+			{
+				pSelection[row] &= static_cast<uint8_t>((pValues[row] >= lower) & (pValues[row] <= upper));
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Keeps rows with start <= timestamp < end
+
+	void CSVTable::FilterTime (time_t start, time_t end, std::vector<uint8_t>& selection) const noexcept
+	{
+		if (selection.size () != m_rowCount || m_timestamps.size () != m_rowCount) return;
+
+		uint8_t* pSelection = selection.data ();
+		const time_t* pTimestamps = m_timestamps.data ();
+
+		for (size_t row = 0; row < m_rowCount; ++row)
+		{
+			pSelection[row] &= static_cast<uint8_t>((pTimestamps[row] >= start) & (pTimestamps[row] < end));
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVAggregate CSVTable::Aggregate (size_t column) const noexcept
+	{
+		if (column >= m_columns.size ()) return {};
+		if (m_columns[column].type == CSVColumn::Type::Float) return AggregateValues (GetFloats (column), nullptr);
+		if (!m_columns[column].integers.empty ()) return AggregateValues (GetIntegers (column), nullptr);
+		return AggregateValues (GetTimes (column), nullptr);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	CSVAggregate CSVTable::Aggregate (size_t column, const std::vector<uint8_t>& selection) const noexcept
+	{
+		if (column >= m_columns.size () || selection.size () != m_rowCount) return {};
+		if (m_columns[column].type == CSVColumn::Type::Float) return AggregateValues (GetFloats (column), selection.data ());
+		if (!m_columns[column].integers.empty ()) return AggregateValues (GetIntegers (column), selection.data ());
+		return AggregateValues (GetTimes (column), selection.data ());
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	/// Each lane keeps its own totals so the additions can run side by side
+	/// without reordering a single floating point sum
+
+	template <typename T>
+	CSVAggregate CSVTable::AggregateValues (std::span<const T> values, const uint8_t* pSelection) const noexcept
+	{
+		constexpr size_t Lanes = 8;
+
+		double sums[Lanes] {};
+		double minimums[Lanes];
+		double maximums[Lanes];
+		size_t counts[Lanes] {};
+
+		std::fill (minimums, minimums + Lanes, INFINITY);
+		std::fill (maximums, maximums + Lanes, -INFINITY);
+
+		auto accumulate = [&](size_t lane, size_t row)
+		{
+			double value = static_cast<double>(values[row]);
+			bool include = (value == value) && (pSelection == nullptr || pSelection[row] != 0);
+
+			sums[lane] += include ? value : 0.0;
+			counts[lane] += include;
+			minimums[lane] = (include && value < minimums[lane]) ? value : minimums[lane];
+			maximums[lane] = (include && value > maximums[lane]) ? value : maximums[lane];
+		};
+
+		size_t row = 0;
+
+		for (; row + Lanes <= values.size (); row += Lanes)
+		{
+			for (size_t lane = 0; lane < Lanes; ++lane) accumulate (lane, row + lane);
+		}
+
+		for (size_t lane = 0; row < values.size (); ++row, ++lane) accumulate (lane, row);
+
+		CSVAggregate aggregate;
+
+		for (size_t lane = 0; lane < Lanes; ++lane)
+		{
+			aggregate.count += counts[lane];
+			aggregate.sum += sums[lane];
+			if (counts[lane] > 0) aggregate.minimum = std::isnan (aggregate.minimum) ? minimums[lane] : std::min (aggregate.minimum, minimums[lane]);
+			if (counts[lane] > 0) aggregate.maximum = std::isnan (aggregate.maximum) ? maximums[lane] : std::max (aggregate.maximum, maximums[lane]);
+		}
+
+		return aggregate;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVTable::Convert (const CSVChunk& chunk, Partial& partial) const
+	{
+		const size_t rowCount = chunk.GetRowCount ();
+		CSVTimeParser timeParser;
+
+		partial.rowCount = rowCount;
+		partial.columns.resize (m_columns.size ());
+
+		for (size_t column = 0; column < m_columns.size (); ++column)
+		{
+			Column& target = partial.columns[column];
+			target.type = m_columns[column].type;
+
+			switch (target.type)
+			{
+			case	CSVColumn::Type::Float:
+				target.floats.resize (rowCount);
+				for (size_t row = 0; row < rowCount; ++row)
+				{
+					if (!chunk.GetFieldAs (row, column, target.floats[row])) target.floats[row] = NAN;
+				}
+				break;
+
+			case	CSVColumn::Type::Int:
+			case	CSVColumn::Type::Row:
+				target.integers.resize (rowCount);
+				for (size_t row = 0; row < rowCount; ++row)
+				{
+					if (!chunk.GetFieldAs (row, column, target.integers[row])) target.integers[row] = 0;
+				}
+				break;
+
+			case	CSVColumn::Type::Date:
+				target.times.resize (rowCount);
+				for (size_t row = 0; row < rowCount; ++row)
+				{
+					if (!timeParser.ParseDate (chunk.GetField (row, column), target.times[row])) target.times[row] = -1;
+				}
+				break;
+
+			case	CSVColumn::Type::Time:
+				target.times.resize (rowCount);
+				for (size_t row = 0; row < rowCount; ++row)
+				{
+					if (!CSVTimeParser::ParseTimeOfDay (chunk.GetField (row, column), target.times[row])) target.times[row] = -1;
+				}
+				break;
+
+			case	CSVColumn::Type::String:
+				target.textEnds.resize (rowCount);
+				for (size_t row = 0; row < rowCount; ++row)
+				{
+					target.text.append (chunk.GetField (row, column));
+					target.textEnds[row] = target.text.length ();
+				}
+				break;
+			}
+		}
+
+		if (m_dateColumn >= 0 && m_timeColumn >= 0)
+		{
+			partial.timestamps.resize (rowCount);
+
+			for (size_t row = 0; row < rowCount; ++row)
+			{
+				if (!timeParser.ParseTimestamp (chunk.GetField (row, m_dateColumn), chunk.GetField (row, m_timeColumn), partial.timestamps[row]))
+				{
+					partial.timestamps[row] = -1;
+				}
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void CSVTable::Append (Partial& partial)
+	{
+		for (size_t column = 0; column < m_columns.size (); ++column) m_columns[column].Append (partial.columns[column]);
+
+		m_timestamps.insert (m_timestamps.end (), partial.timestamps.begin (), partial.timestamps.end ());
+		m_rowCount += partial.rowCount;
+		partial = Partial {};
+	}
+}
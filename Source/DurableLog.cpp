@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "DurableLog.h"
+
+#include "spdlog/spdlog.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	DurableLog::DurableLog () noexcept :
+		m_pendingCommit (std::make_shared<Commit> ()),
+		m_committing (false),
+		m_recordCount (0),
+		m_commitCount (0)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	DurableLog::~DurableLog () noexcept
+	{
+		Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool DurableLog::Open (const std::string& pathName) noexcept
+	{
+		Close ();
+
+		std::scoped_lock lock (m_logMutex);
+
+		if (m_fileObject.Open (pathName, true)) return true;
+		if (!m_fileObject.Create (pathName)) return false;
+
+		// A new file is only durable once its directory entry is
+		size_t separator = pathName.find_last_of ('/');
+		std::string directoryName = (separator == std::string::npos) ? "." : pathName.substr (0, separator + 1);
+
+		int32_t directoryHandle = open (directoryName.c_str (), O_RDONLY|O_DIRECTORY);
+		if (directoryHandle < 0 || fsync (directoryHandle) != 0)
+		{
+			spdlog::error ("Unable to sync directory {0} with error number {1}", directoryName, errno);
+		}
+		if (directoryHandle >= 0) close (directoryHandle);
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void DurableLog::Close () noexcept
+	{
+		std::unique_lock lock (m_logMutex);
+
+		m_commitDone.wait (lock, [this] { return !m_committing; });
+
+		// Nobody is waiting on records without a committer, so this is a plain sync
+		if (!m_pendingData.empty ())
+		{
+			m_pendingCommit->m_durable = m_fileObject.Write (m_pendingData.data (), m_pendingData.size ()) && m_fileObject.Sync ();
+			m_pendingCommit->m_complete = true;
+			m_pendingCommit = std::make_shared<Commit> ();
+			m_pendingData.clear ();
+		}
+
+		m_fileObject.Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool DurableLog::Append (const uint8_t* pBuffer, size_t length) noexcept
+	{
+		if (length == 0) return false;
+
+		std::unique_lock lock (m_logMutex);
+
+		if (!m_fileObject.IsOpen ()) return false;
+
+		m_pendingData.insert (m_pendingData.end (), pBuffer, pBuffer + length);
+		std::shared_ptr<Commit> commit = m_pendingCommit;
+		++m_recordCount;
+
+		while (!commit->m_complete)
+		{
+			if (m_committing)
+			{
+				m_commitDone.wait (lock);
+				continue;
+			}
+
+			// No sync in flight so this caller commits everything gathered so far
+			m_committing = true;
+			std::shared_ptr<Commit> leaderCommit = m_pendingCommit;
+			m_pendingCommit = std::make_shared<Commit> ();
+			m_commitData.swap (m_pendingData);
+
+			lock.unlock ();
+			bool durable = m_fileObject.Write (m_commitData.data (), m_commitData.size ()) && m_fileObject.Sync ();
+			m_commitData.clear ();
+			lock.lock ();
+
+			leaderCommit->m_durable = durable;
+			leaderCommit->m_complete = true;
+			m_committing = false;
+			++m_commitCount;
+
+			m_commitDone.notify_all ();
+		}
+
+		return commit->m_durable;
+	}
+}
@@ -25,8 +25,11 @@
 
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstring>
+#include <sys/stat.h>
 #include <unistd.h>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -38,7 +41,13 @@ namespace spc
 	///
 
 	FileObject::FileObject () noexcept :
-		m_handleId (INVALID_HANDLE_VALUE)
+		m_handleId (INVALID_HANDLE_VALUE),
+		m_readOffset (0),
+		m_readLength (0),
+		m_writeBufferSize (0),
+		m_flushInterval (0),
+		m_syscallCount (0),
+		m_directIO (false)
 	{
 	}
 
@@ -57,6 +66,8 @@ namespace spc
 	{
 		if (m_handleId != INVALID_HANDLE_VALUE)
 		{
+			(void)Flush ();
+
 			if (close (m_handleId) == 0)
 			{
 				spdlog::trace ("Closed {0} ", m_pathName);
@@ -69,6 +80,9 @@ namespace spc
 			m_handleId = INVALID_HANDLE_VALUE;
 			m_pathName = "";
 		}
+
+		DiscardReadBuffer ();
+		m_directIO = false;
 	}
 
 	////////////////////////////////////////////////////////////////////////////
@@ -95,6 +109,59 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////
 	///
 
+	bool FileObject::OpenDirect (const std::string& pathName, bool create, mode_t mode) noexcept
+	{
+		Close ();
+
+		// Transfers bypass the page cache so buffers, offsets and lengths must be block aligned
+		m_handleId = open (pathName.c_str (), O_RDWR|O_DIRECT|((create) ? O_CREAT|O_TRUNC : 0), mode);
+		if (m_handleId < 0)
+		{
+			spdlog::error ("Failed to open {0} for direct I/O with error number {1}", pathName, errno);
+			m_handleId = INVALID_HANDLE_VALUE;
+			return false;
+		}
+
+		m_pathName = pathName;
+		m_directIO = true;
+
+		// The write buffer is not aligned so it cannot be used
+		SetWriteBuffer (0);
+
+		spdlog::info ("Opened {0} for direct I/O", m_pathName);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileObject::GetDirectAlignment () const noexcept
+	{
+		if (!IsOpen ()) return 0;
+
+#ifdef STATX_DIOALIGN
+		struct statx directStatus {};
+		if (statx (m_handleId, "", AT_EMPTY_PATH, STATX_DIOALIGN, &directStatus) == 0 &&
+			(directStatus.stx_mask & STATX_DIOALIGN) && directStatus.stx_dio_offset_align != 0)
+		{
+			return std::max (directStatus.stx_dio_mem_align, directStatus.stx_dio_offset_align);
+		}
+#endif
+
+		// Older kernels do not report it, the preferred block size is always a safe multiple
+		struct stat fileStatus {};
+		if (fstat (m_handleId, &fileStatus) != 0)
+		{
+			spdlog::error ("Unable to stat {0} with error number {1}", m_pathName, errno);
+			return 0;
+		}
+
+		return static_cast<size_t>(fileStatus.st_blksize);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
 	bool FileObject::Create (const std::string& pathName, mode_t mode) noexcept
 	{
 		Close ();
@@ -116,7 +183,7 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////
 	///
 
-	bool FileObject::Write (const uint8_t* pBuffer, size_t length) const noexcept
+	bool FileObject::Write (const uint8_t* pBuffer, size_t length) noexcept
 	{
 		if (length == 0)
 		{
@@ -125,18 +192,54 @@ namespace spc
 		}
 
 		if (!IsOpen ()) return false;
+		if (m_writeBufferSize == 0) return WriteDirect (pBuffer, length);
+
+		if (m_writeBuffer.size () + length > m_writeBufferSize)
+		{
+			if (!Flush ()) return false;
 
-		ssize_t bytesWritten = 0;
+			// Too big to ever coalesce so send it straight through
+			if (length >= m_writeBufferSize) return WriteDirect (pBuffer, length);
+		}
 
-		while (bytesWritten < static_cast<ssize_t>(length) && bytesWritten != -1)
+		if (m_writeBuffer.empty () && m_flushInterval.count () > 0)
 		{
-			bytesWritten += write (m_handleId, &pBuffer[bytesWritten], length - bytesWritten);
+			m_bufferedSince = std::chrono::steady_clock::now ();
 		}
 
-		if (bytesWritten == -1)
+		m_writeBuffer.insert (m_writeBuffer.end (), pBuffer, pBuffer + length);
+
+		// The interval is only checked here, there is no background flushing
+		if (m_writeBuffer.size () >= m_writeBufferSize ||
+			(m_flushInterval.count () > 0 && std::chrono::steady_clock::now () - m_bufferedSince >= m_flushInterval))
 		{
-			spdlog::error ("Unable to write all data to {0} with error number {1}", m_pathName, errno);
-			return false;
+			return Flush ();
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::WriteDirect (const uint8_t* pBuffer, size_t length) noexcept
+	{
+		size_t bytesWritten = 0;
+
+		while (bytesWritten < length)
+		{
+			++m_syscallCount;
+
+			ssize_t result = write (m_handleId, &pBuffer[bytesWritten], length - bytesWritten);
+			if (result == -1)
+			{
+				if (errno == EINTR) continue;
+
+				spdlog::error ("Unable to write all data to {0} with error number {1}", m_pathName, errno);
+				return false;
+			}
+
+			bytesWritten += static_cast<size_t>(result);
 		}
 
 		spdlog::trace ("Wrote {0} bytes to {1}", bytesWritten, m_pathName);
@@ -146,10 +249,202 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////
 	///
 
+	bool FileObject::Flush () noexcept
+	{
+		if (m_writeBuffer.empty ()) return true;
+
+		// Failed data is dropped rather than retried so a partial write is never repeated
+		bool writeValid = IsOpen () && WriteDirect (m_writeBuffer.data (), m_writeBuffer.size ());
+		m_writeBuffer.clear ();
+		return writeValid;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::WriteV (std::span<const iovec> vectors) noexcept
+	{
+		size_t length = 0;
+		for (const iovec& vector : vectors) length += vector.iov_len;
+
+		if (length == 0)
+		{
+			spdlog::debug ("Attempting to write 0 bytes to {0}", m_pathName);
+			return false;
+		}
+
+		if (!IsOpen ()) return false;
+
+		// Small enough to coalesce with the write buffer, which is a copy either way
+		if (m_writeBufferSize != 0 && length < m_writeBufferSize)
+		{
+			for (const iovec& vector : vectors)
+			{
+				if (vector.iov_len == 0) continue;
+				if (!Write (static_cast<const uint8_t*>(vector.iov_base), vector.iov_len)) return false;
+			}
+
+			return true;
+		}
+
+		if (!Flush ()) return false;
+
+		size_t index = 0;
+
+		while (index < vectors.size ())
+		{
+			int count = static_cast<int>(std::min (vectors.size () - index, static_cast<size_t>(IOV_MAX)));
+
+			++m_syscallCount;
+			ssize_t result = writev (m_handleId, &vectors[index], count);
+			if (result == -1)
+			{
+				if (errno == EINTR) continue;
+
+				spdlog::error ("Unable to write all data to {0} with error number {1}", m_pathName, errno);
+				return false;
+			}
+
+			size_t bytesWritten = static_cast<size_t>(result);
+			while (index < vectors.size () && bytesWritten >= vectors[index].iov_len)
+			{
+				bytesWritten -= vectors[index++].iov_len;
+			}
+
+			// A short write part way through a vector finishes that vector on its own
+			if (bytesWritten > 0)
+			{
+				const uint8_t* pRemaining = static_cast<const uint8_t*>(vectors[index].iov_base) + bytesWritten;
+				if (!WriteDirect (pRemaining, vectors[index].iov_len - bytesWritten)) return false;
+				++index;
+			}
+		}
+
+		spdlog::trace ("Wrote {0} bytes to {1}", length, m_pathName);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::WriteAt (const uint8_t* pBuffer, size_t length, off_t offset) const noexcept
+	{
+		if (length == 0)
+		{
+			spdlog::debug ("Attempting to write 0 bytes to {0}", m_pathName);
+			return false;
+		}
+
+		if (!IsOpen ()) return false;
+
+		size_t bytesWritten = 0;
+
+		while (bytesWritten < length)
+		{
+			++m_syscallCount;
+
+			ssize_t result = pwrite (m_handleId, &pBuffer[bytesWritten], length - bytesWritten, offset + bytesWritten);
+			if (result == -1)
+			{
+				if (errno == EINTR) continue;
+
+				spdlog::error ("Unable to write all data to {0} at {1} with error number {2}", m_pathName, offset, errno);
+				return false;
+			}
+
+			bytesWritten += static_cast<size_t>(result);
+		}
+
+		spdlog::trace ("Wrote {0} bytes to {1} at {2}", bytesWritten, m_pathName, offset);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileObject::ReadAt (uint8_t* pBuffer, size_t length, off_t offset) const noexcept
+	{
+		if (!IsOpen ()) return 0;
+
+		ssize_t bytesRead = -1;
+
+		do
+		{
+			++m_syscallCount;
+			bytesRead = pread (m_handleId, pBuffer, length, offset);
+		}
+		while (bytesRead == -1 && errno == EINTR);
+
+		if (bytesRead == -1)
+		{
+			spdlog::error ("Unable to read any data from {0} at {1} with error number {2}", m_pathName, offset, errno);
+			return 0;
+		}
+
+		if (bytesRead > 0)
+		{
+			spdlog::trace ("Read {0} bytes from {1} at {2}", bytesRead, m_pathName, offset);
+		}
+		return static_cast<size_t>(bytesRead);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::Sync (bool dataOnly) noexcept
+	{
+		if (!IsOpen ()) return false;
+		if (!Flush ()) return false;
+
+		++m_syscallCount;
+		if (((dataOnly) ? fdatasync (m_handleId) : fsync (m_handleId)) != 0)
+		{
+			spdlog::error ("Unable to sync {0} with error number {1}", m_pathName, errno);
+			return false;
+		}
+
+		spdlog::trace ("Synced {0}", m_pathName);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void FileObject::SetWriteBuffer (size_t bufferSize, uint32_t flushIntervalms) noexcept
+	{
+		(void)Flush ();
+
+		if (m_directIO && bufferSize != 0)
+		{
+			spdlog::error ("Write buffering is not available for direct I/O on {0}", m_pathName);
+			bufferSize = 0;
+		}
+
+		m_writeBufferSize = bufferSize;
+		m_flushInterval = std::chrono::milliseconds (flushIntervalms);
+
+		m_writeBuffer.shrink_to_fit ();
+		m_writeBuffer.reserve (bufferSize);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
 	size_t FileObject::Read (uint8_t* pBuffer, size_t length) noexcept
 	{
 		if (!IsOpen ()) return 0;
+		if (!Flush ()) return 0;
+
+		// Anything left over from a buffered line read comes first
+		if (m_readOffset < m_readLength)
+		{
+			size_t bufferedBytes = std::min (length, m_readLength - m_readOffset);
+			std::memcpy (pBuffer, &m_readBuffer[m_readOffset], bufferedBytes);
+			m_readOffset += bufferedBytes;
+			return bufferedBytes;
+		}
 
+		++m_syscallCount;
 		ssize_t bytesRead = read (m_handleId, (void*)pBuffer, length);
 		if (bytesRead == -1)
 		{
@@ -167,10 +462,34 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////////
 	///
 
+	bool FileObject::Seek (off_t offset) noexcept
+	{
+		if (!IsOpen ()) return false;
+
+		DiscardReadBuffer ();
+		if (!Flush ()) return false;
+
+		++m_syscallCount;
+		if (lseek (m_handleId, offset, SEEK_SET) == -1)
+		{
+			spdlog::error ("Unable to seek to {0} in {1} with error number {2}", offset, m_pathName, errno);
+			return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
 	bool FileObject::SeekEnd () noexcept
 	{
 		if (!IsOpen ()) return false;
 
+		DiscardReadBuffer ();
+		if (!Flush ()) return false;
+
+		++m_syscallCount;
 		off_t offset = lseek (m_handleId, 0, SEEK_END);
 		if (offset == -1)
 		{
@@ -185,25 +504,196 @@ namespace spc
 	////////////////////////////////////////////////////////////////////////////
 	///
 
+	off_t FileObject::Tell () noexcept
+	{
+		if (!IsOpen ()) return -1;
+
+		++m_syscallCount;
+		off_t offset = lseek (m_handleId, 0, SEEK_CUR);
+		if (offset == -1)
+		{
+			spdlog::error ("Unable to get position of {0} with error number {1}", m_pathName, errno);
+			return -1;
+		}
+
+		// Report the position as the caller sees it, not as the kernel does
+		return offset + static_cast<off_t>(m_writeBuffer.size ()) - static_cast<off_t>(m_readLength - m_readOffset);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::Truncate (off_t length) noexcept
+	{
+		if (!IsOpen ()) return false;
+		if (!Flush ()) return false;
+
+		++m_syscallCount;
+		if (ftruncate (m_handleId, length) != 0)
+		{
+			spdlog::error ("Unable to truncate {0} to {1} bytes with error number {2}", m_pathName, length, errno);
+			return false;
+		}
+
+		spdlog::trace ("Truncated {0} to {1} bytes", m_pathName, length);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::Preallocate (off_t length, off_t offset, bool keepSize) noexcept
+	{
+		if (!IsOpen ()) return false;
+
+		++m_syscallCount;
+		if (fallocate (m_handleId, (keepSize) ? FALLOC_FL_KEEP_SIZE : 0, offset, length) != 0)
+		{
+			spdlog::error ("Unable to preallocate {0} bytes for {1} with error number {2}", length, m_pathName, errno);
+			return false;
+		}
+
+		spdlog::trace ("Preallocated {0} bytes at {1} for {2}", length, offset, m_pathName);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::Advise (Access access, off_t offset, off_t length) noexcept
+	{
+		if (!IsOpen ()) return false;
+
+		int advice = POSIX_FADV_NORMAL;
+
+		switch (access)
+		{
+		case	Access::Normal: advice = POSIX_FADV_NORMAL; break;
+		case	Access::Sequential: advice = POSIX_FADV_SEQUENTIAL; break;
+		case	Access::Random: advice = POSIX_FADV_RANDOM; break;
+		case	Access::WillNeed: advice = POSIX_FADV_WILLNEED; break;
+		case	Access::DontNeed: advice = POSIX_FADV_DONTNEED; break;
+		case	Access::NoReuse: advice = POSIX_FADV_NOREUSE; break;
+		}
+
+		// posix_fadvise returns the error rather than setting errno
+		++m_syscallCount;
+		int result = posix_fadvise (m_handleId, offset, length, advice);
+		if (result != 0)
+		{
+			spdlog::error ("Unable to advise {0} with error number {1}", m_pathName, result);
+			return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::StartWriteBack (off_t offset, off_t length) noexcept
+	{
+		if (!IsOpen ()) return false;
+
+		++m_syscallCount;
+		if (sync_file_range (m_handleId, offset, length, SYNC_FILE_RANGE_WRITE) != 0)
+		{
+			spdlog::error ("Unable to start write back of {0} with error number {1}", m_pathName, errno);
+			return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool FileObject::WaitWriteBack (off_t offset, off_t length) noexcept
+	{
+		if (!IsOpen ()) return false;
+
+		++m_syscallCount;
+		if (sync_file_range (m_handleId, offset, length, SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|SYNC_FILE_RANGE_WAIT_AFTER) != 0)
+		{
+			spdlog::error ("Unable to complete write back of {0} with error number {1}", m_pathName, errno);
+			return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileObject::FillReadBuffer () noexcept
+	{
+		DiscardReadBuffer ();
+
+		if (!IsOpen () || m_readBuffer.empty ()) return 0;
+		if (!Flush ()) return 0;
+
+		++m_syscallCount;
+		ssize_t bytesRead = read (m_handleId, m_readBuffer.data (), m_readBuffer.size ());
+		if (bytesRead == -1)
+		{
+			spdlog::error ("Unable to read any data from {0} with error number {1}", m_pathName, errno);
+			return 0;
+		}
+
+		if (bytesRead > 0)
+		{
+			spdlog::trace ("Read {0} bytes from {1}", bytesRead, m_pathName);
+		}
+
+		m_readLength = static_cast<size_t>(bytesRead);
+		return m_readLength;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void ASCIIFileObject::SetReadBufferSize (size_t bufferSize) noexcept
+	{
+		if (bufferSize == 0) bufferSize = 1;
+		if (bufferSize == m_readBuffer.size ()) return;
+
+		// Keep any unread bytes so a resize part way through a file is lossless
+		size_t unreadBytes = m_readLength - m_readOffset;
+		std::vector<uint8_t> newBuffer (std::max (bufferSize, unreadBytes));
+		if (unreadBytes > 0) std::memcpy (newBuffer.data (), &m_readBuffer[m_readOffset], unreadBytes);
+
+		m_readLength = unreadBytes;
+		m_readOffset = 0;
+		m_readBuffer.swap (newBuffer);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
 	bool ASCIIFileObject::ReadNextLine (std::string& nextLine) noexcept
-    {
-		uint8_t nextByte = 0;
+	{
+		if (m_readBuffer.empty ()) SetReadBufferSize (DefaultReadBufferSize);
 
 		nextLine.clear ();
 
-		while (Read (&nextByte, 1) != 0)
+		while (m_readOffset < m_readLength || FillReadBuffer () != 0)
 		{
-			if (nextByte == CarriageReturn || nextByte == LineFeed)
+			const char* pStart = reinterpret_cast<const char*>(&m_readBuffer[m_readOffset]);
+			const char* pEnd = pStart + (m_readLength - m_readOffset);
+			const char* pNext = std::find_if (pStart, pEnd, [](char next) { return next == CarriageReturn || next == LineFeed; });
+
+			// A line may straddle the end of the buffer, so append and carry on
+			nextLine.append (pStart, pNext - pStart);
+			m_readOffset += pNext - pStart;
+
+			if (pNext != pEnd)
 			{
+				++m_readOffset;
 				if (!nextLine.empty ())
 				{
 					return true;
 				}
 			}
-			else
-			{
-				nextLine += static_cast<char>(nextByte);
-			}
 		}
 
 		return false;
@@ -222,6 +712,6 @@ namespace spc
 
 	bool ASCIIFileObject::WriteNewLine () noexcept
 	{
-		return Write (reinterpret_cast<const uint8_t*>(NewLineString), sizeof (NewLineString) - 1);
+		return WriteString (NewLineString);
 	}
 }
@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "FileTransfer.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileTransfer::RemainingLength (FileObject& fromFile, off_t offset, size_t length) noexcept
+	{
+		// Anything still sitting in the source write buffer must reach the kernel first
+		if (!fromFile.Flush ()) return 0;
+		if (length != 0) return length;
+
+		struct stat fileStatus {};
+		if (fstat (fromFile.GetHandle (), &fileStatus) != 0)
+		{
+			spdlog::error ("Unable to size transfer source with error number {0}", errno);
+			return 0;
+		}
+
+		return (fileStatus.st_size > offset) ? static_cast<size_t>(fileStatus.st_size - offset) : 0;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileTransfer::SendFile (int32_t toHandle, int32_t fromHandle, off_t offset, size_t length) noexcept
+	{
+		size_t bytesSent = 0;
+
+		while (bytesSent < length)
+		{
+			ssize_t result = sendfile (toHandle, fromHandle, &offset, std::min (length - bytesSent, MaximumChunkSize));
+			if (result == -1)
+			{
+				if (errno == EINTR) continue;
+
+				spdlog::error ("Unable to send file data with error number {0}", errno);
+				break;
+			}
+
+			if (result == 0) break;
+			bytesSent += static_cast<size_t>(result);
+		}
+
+		return bytesSent;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileTransfer::FileToSocket (FileObject& fromFile, SocketObject& toSocket, off_t offset, size_t length) noexcept
+	{
+		if (!fromFile.IsOpen () || !toSocket.IsOpen ()) return 0;
+
+		length = RemainingLength (fromFile, offset, length);
+		if (length == 0) return 0;
+
+		size_t bytesSent = SendFile (toSocket.GetHandle (), fromFile.GetHandle (), offset, length);
+
+		spdlog::trace ("Sent {0} of {1} bytes from file to socket", bytesSent, length);
+		return bytesSent;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileTransfer::FileToFile (FileObject& fromFile, FileObject& toFile, off_t offset, size_t length) noexcept
+	{
+		if (!fromFile.IsOpen () || !toFile.IsOpen ()) return 0;
+
+		length = RemainingLength (fromFile, offset, length);
+		if (length == 0 || !toFile.Flush ()) return 0;
+
+		size_t bytesCopied = 0;
+
+		// Neither kernel copy accepts an append only target so copy through user space
+		if (fcntl (toFile.GetHandle (), F_GETFL) & O_APPEND)
+		{
+			std::vector<uint8_t> copyBuffer (std::min (length, CopyBufferSize));
+
+			while (bytesCopied < length)
+			{
+				size_t bytesRead = fromFile.ReadAt (copyBuffer.data (), std::min (length - bytesCopied, copyBuffer.size ()), offset);
+				if (bytesRead == 0 || !toFile.Write (copyBuffer.data (), bytesRead)) break;
+
+				offset += bytesRead;
+				bytesCopied += bytesRead;
+			}
+
+			spdlog::trace ("Copied {0} of {1} bytes from file to append only file", bytesCopied, length);
+			return bytesCopied;
+		}
+
+		// copy_file_range can share extents on the same filesystem, anything
+		// it refuses such as a cross device copy uses sendfile
+		while (bytesCopied < length)
+		{
+			ssize_t result = copy_file_range (fromFile.GetHandle (), &offset, toFile.GetHandle (), nullptr,
+				std::min (length - bytesCopied, MaximumChunkSize), 0);
+
+			if (result == -1)
+			{
+				if (errno == EINTR) continue;
+
+				if (errno == EXDEV || errno == EINVAL || errno == EBADF || errno == ENOSYS || errno == EOPNOTSUPP)
+				{
+					bytesCopied += SendFile (toFile.GetHandle (), fromFile.GetHandle (), offset, length - bytesCopied);
+					break;
+				}
+
+				spdlog::error ("Unable to copy file data with error number {0}", errno);
+				break;
+			}
+
+			if (result == 0) break;
+			bytesCopied += static_cast<size_t>(result);
+		}
+
+		spdlog::trace ("Copied {0} of {1} bytes from file to file", bytesCopied, length);
+		return bytesCopied;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	size_t FileTransfer::SocketToFile (SocketObject& fromSocket, FileObject& toFile, size_t length) noexcept
+	{
+		if (!fromSocket.IsOpen () || !toFile.IsOpen () || length == 0) return 0;
+		if (!toFile.Flush ()) return 0;
+
+		// splice needs a pipe on one side, so data goes socket to pipe to file
+		int pipeHandles[2];
+		if (pipe2 (pipeHandles, O_CLOEXEC) != 0)
+		{
+			spdlog::error ("Unable to create splice pipe with error number {0}", errno);
+			return 0;
+		}
+
+		size_t bytesMoved = 0;
+
+		while (bytesMoved < length)
+		{
+			ssize_t inPipe = splice (fromSocket.GetHandle (), nullptr, pipeHandles[1], nullptr,
+				std::min (length - bytesMoved, MaximumChunkSize), SPLICE_F_MOVE|SPLICE_F_MORE);
+
+			if (inPipe == -1 && errno == EINTR) continue;
+			if (inPipe <= 0)
+			{
+				if (inPipe == -1) spdlog::error ("Unable to splice from socket with error number {0}", errno);
+				break;
+			}
+
+			ssize_t drained = 0;
+			while (drained < inPipe)
+			{
+				ssize_t result = splice (pipeHandles[0], nullptr, toFile.GetHandle (), nullptr, inPipe - drained, SPLICE_F_MOVE);
+				if (result == -1 && errno == EINTR) continue;
+				if (result <= 0)
+				{
+					spdlog::error ("Unable to splice to file with error number {0}", errno);
+					break;
+				}
+
+				drained += result;
+			}
+
+			bytesMoved += static_cast<size_t>(drained);
+			if (drained < inPipe) break;
+		}
+
+		close (pipeHandles[0]);
+		close (pipeHandles[1]);
+
+		spdlog::trace ("Moved {0} of {1} bytes from socket to file", bytesMoved, length);
+		return bytesMoved;
+	}
+}
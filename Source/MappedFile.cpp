@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "MappedFile.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	MappedFile::MappedFile () noexcept :
+		m_pData (nullptr),
+		m_size (0),
+		m_offset (0),
+		m_isOpen (false)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	MappedFile::~MappedFile () noexcept
+	{
+		Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void MappedFile::Close () noexcept
+	{
+		if (m_pData != nullptr)
+		{
+			if (munmap (const_cast<uint8_t*>(m_pData), m_size) == 0)
+			{
+				spdlog::trace ("Unmapped {0}", m_pathName);
+			}
+			else
+			{
+				spdlog::error ("Failed to unmap {0} with error number {1}", m_pathName, errno);
+			}
+		}
+
+		m_pData = nullptr;
+		m_size = 0;
+		m_offset = 0;
+		m_isOpen = false;
+		m_pathName = "";
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool MappedFile::Open (const std::string& pathName, Access access) noexcept
+	{
+		Close ();
+
+		int32_t handleId = open (pathName.c_str (), O_RDONLY);
+		if (handleId < 0)
+		{
+			spdlog::error ("Failed to open {0} with error number {1}", pathName, errno);
+			return false;
+		}
+
+		struct stat fileStatus {};
+		if (fstat (handleId, &fileStatus) != 0)
+		{
+			spdlog::error ("Failed to stat {0} with error number {1}", pathName, errno);
+			close (handleId);
+			return false;
+		}
+
+		// A zero length mapping is invalid so an empty file is simply an empty span
+		if (fileStatus.st_size > 0)
+		{
+			void* pMapping = mmap (nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, handleId, 0);
+			if (pMapping == MAP_FAILED)
+			{
+				spdlog::error ("Failed to map {0} with error number {1}", pathName, errno);
+				close (handleId);
+				return false;
+			}
+
+			m_pData = static_cast<const uint8_t*>(pMapping);
+			m_size = static_cast<size_t>(fileStatus.st_size);
+		}
+
+		// The mapping holds its own reference to the file
+		close (handleId);
+
+		m_pathName = pathName;
+		m_isOpen = true;
+
+		(void)Advise (access);
+
+		spdlog::info ("Mapped {0} bytes of {1}", m_size, m_pathName);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool MappedFile::Advise (Access access, size_t offset, size_t length) noexcept
+	{
+		if (m_pData == nullptr || offset >= m_size) return false;
+
+		int advice = MADV_NORMAL;
+
+		switch (access)
+		{
+		case	Access::Normal: advice = MADV_NORMAL; break;
+		case	Access::Sequential: advice = MADV_SEQUENTIAL; break;
+		case	Access::Random: advice = MADV_RANDOM; break;
+		case	Access::WillNeed: advice = MADV_WILLNEED; break;
+		case	Access::DontNeed: advice = MADV_DONTNEED; break;
+		}
+
+		// madvise wants a page aligned start address
+		size_t pageMask = static_cast<size_t>(sysconf (_SC_PAGESIZE)) - 1;
+		size_t alignedOffset = offset & ~pageMask;
+		length = std::min (length, m_size - offset) + (offset - alignedOffset);
+
+		if (madvise (const_cast<uint8_t*>(m_pData) + alignedOffset, length, advice) != 0)
+		{
+			spdlog::error ("Unable to advise mapping of {0} with error number {1}", m_pathName, errno);
+			return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool MappedFile::ReadNextLine (std::string_view& nextLine) noexcept
+	{
+		const std::string_view text = GetText ();
+
+		nextLine = std::string_view ();
+
+		while (m_offset < m_size)
+		{
+			size_t lineEnd = text.find_first_of ("\r\n", m_offset);
+
+			if (lineEnd == std::string_view::npos)
+			{
+				// Same as ASCIIFileObject, a final unterminated line is returned as false
+				nextLine = text.substr (m_offset);
+				m_offset = m_size;
+				return false;
+			}
+
+			nextLine = text.substr (m_offset, lineEnd - m_offset);
+			m_offset = lineEnd + 1;
+
+			if (!nextLine.empty ())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
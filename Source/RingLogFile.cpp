@@ -0,0 +1,331 @@
+////////////////////////////////////////////////////////////////////////////////
+/// MIT License
+///
+/// Copyright 2020-2023 Simon Clark
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy
+/// of this software and associated documentation files (the “Software”), to
+/// deal in the Software without restriction, including without limitation the
+/// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+/// sell copies of the Software, and to permit persons to whom the Software is
+/// furnished to do so, subject to the following conditions:
+///
+/// The above copyright notice and this permission notice shall be included in
+/// all copies or substantial portions of the Software.
+///
+/// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+/// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+/// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+/// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+/// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+/// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+/// THE SOFTWARE.
+
+#include "RingLogFile.h"
+#include "MappedFile.h"
+
+#include "spdlog/spdlog.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+////////////////////////////////////////////////////////////////////////////////
+///
+
+namespace spc
+{
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	namespace
+	{
+		constexpr uint64_t AlignRecord (uint64_t length) noexcept
+		{
+			return (length + RingLogFile::RecordAlignment - 1) & ~(RingLogFile::RecordAlignment - 1);
+		}
+
+		bool IsValidHeader (const RingLogFile::Header& header, size_t fileSize) noexcept
+		{
+			return std::memcmp (header.m_magic, RingLogFile::Magic, sizeof (header.m_magic)) == 0 &&
+				header.m_version == RingLogFile::Version &&
+				header.m_headerSize == sizeof (RingLogFile::Header) &&
+				header.m_capacity + sizeof (RingLogFile::Header) <= fileSize &&
+				header.m_head < header.m_capacity && header.m_tail < header.m_capacity &&
+				header.m_used <= header.m_capacity;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	RingLogFile::RingLogFile () noexcept :
+		m_pHeader (nullptr),
+		m_pData (nullptr),
+		m_mappedSize (0)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	RingLogFile::~RingLogFile () noexcept
+	{
+		Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void RingLogFile::Close () noexcept
+	{
+		if (m_pHeader != nullptr)
+		{
+			(void)Sync ();
+			munmap (m_pHeader, m_mappedSize);
+		}
+
+		m_pHeader = nullptr;
+		m_pData = nullptr;
+		m_mappedSize = 0;
+		m_fileObject.Close ();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool RingLogFile::Create (const std::string& pathName, uint64_t capacity) noexcept
+	{
+		Close ();
+
+		capacity = AlignRecord (capacity);
+		if (capacity < RecordHeaderSize * 2) return false;
+
+		m_mappedSize = sizeof (Header) + capacity;
+
+		if (!m_fileObject.Create (pathName)) return false;
+
+		// Real blocks are reserved up front so a full disk cannot fault a later store
+		if (!m_fileObject.Preallocate (static_cast<off_t>(m_mappedSize), 0, false) &&
+			!m_fileObject.Truncate (static_cast<off_t>(m_mappedSize)))
+		{
+			Close ();
+			return false;
+		}
+
+		// creat() is write only, reopen so the mapping can be read back
+		m_fileObject.Close ();
+		if (!m_fileObject.Open (pathName) || !Map ())
+		{
+			Close ();
+			return false;
+		}
+
+		Header header {};
+		std::memcpy (header.m_magic, Magic, sizeof (header.m_magic));
+		header.m_version = Version;
+		header.m_headerSize = sizeof (Header);
+		header.m_capacity = capacity;
+		*m_pHeader = header;
+
+		spdlog::info ("Created ring log {0} with {1} bytes", pathName, capacity);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool RingLogFile::Open (const std::string& pathName) noexcept
+	{
+		Close ();
+
+		if (!m_fileObject.Open (pathName)) return false;
+
+		struct stat fileStatus {};
+		if (fstat (m_fileObject.GetHandle (), &fileStatus) != 0 || fileStatus.st_size < static_cast<off_t>(sizeof (Header)))
+		{
+			spdlog::error ("Ring log {0} is too small", pathName);
+			Close ();
+			return false;
+		}
+
+		m_mappedSize = static_cast<size_t>(fileStatus.st_size);
+
+		if (!Map () || !IsValidHeader (*m_pHeader, m_mappedSize))
+		{
+			spdlog::error ("Ring log {0} has an invalid header", pathName);
+			Close ();
+			return false;
+		}
+
+		spdlog::info ("Opened ring log {0} holding {1} records", pathName, m_pHeader->m_sequence);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool RingLogFile::Map () noexcept
+	{
+		void* pMapping = mmap (nullptr, m_mappedSize, PROT_READ|PROT_WRITE, MAP_SHARED, m_fileObject.GetHandle (), 0);
+		if (pMapping == MAP_FAILED)
+		{
+			spdlog::error ("Failed to map ring log with error number {0}", errno);
+			return false;
+		}
+
+		m_pHeader = static_cast<Header*>(pMapping);
+		m_pData = static_cast<uint8_t*>(pMapping) + sizeof (Header);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool RingLogFile::Sync (bool wait) noexcept
+	{
+		if (!IsOpen ()) return false;
+
+		if (msync (m_pHeader, m_mappedSize, (wait) ? MS_SYNC : MS_ASYNC) != 0)
+		{
+			spdlog::error ("Unable to sync ring log with error number {0}", errno);
+			return false;
+		}
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	void RingLogFile::MakeSpace (uint64_t length) noexcept
+	{
+		Header& header = *m_pHeader;
+
+		while (header.m_capacity - header.m_used < length && header.m_used > 0)
+		{
+			uint32_t recordLength = 0;
+			std::memcpy (&recordLength, &m_pData[header.m_tail], sizeof (recordLength));
+
+			uint64_t dropped = (recordLength == WrapMarker) ?
+				header.m_capacity - header.m_tail : AlignRecord (RecordHeaderSize + recordLength);
+
+			header.m_used -= dropped;
+			header.m_tail += dropped;
+			if (header.m_tail >= header.m_capacity) header.m_tail = 0;
+		}
+
+		if (header.m_used == 0) header.m_tail = header.m_head;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool RingLogFile::Write (const uint8_t* pBuffer, uint32_t length) noexcept
+	{
+		if (!IsOpen () || length == WrapMarker) return false;
+
+		std::scoped_lock lock (m_writeMutex);
+
+		Header& header = *m_pHeader;
+		uint64_t recordSize = AlignRecord (RecordHeaderSize + length);
+		if (recordSize > header.m_capacity) return false;
+
+		// A record never straddles the end, the remainder is marked and skipped
+		if (recordSize > header.m_capacity - header.m_head)
+		{
+			uint64_t remainder = header.m_capacity - header.m_head;
+			MakeSpace (remainder);
+			std::memcpy (&m_pData[header.m_head], &WrapMarker, sizeof (WrapMarker));
+			header.m_used += remainder;
+			header.m_head = 0;
+		}
+
+		MakeSpace (recordSize);
+
+		uint8_t* pRecord = &m_pData[header.m_head];
+		std::memset (pRecord, 0, RecordHeaderSize);
+		std::memcpy (pRecord, &length, sizeof (length));
+		std::memcpy (pRecord + RecordHeaderSize, pBuffer, length);
+
+		// Header last, so an interrupted write leaves the previous state intact
+		header.m_used += recordSize;
+		header.m_head += recordSize;
+		if (header.m_head >= header.m_capacity) header.m_head = 0;
+		++header.m_sequence;
+
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	uint64_t RingLogFile::WalkRecords (const Header& header, const uint8_t* pData, const RecordHandler& recordHandler) noexcept
+	{
+		uint64_t offset = header.m_tail;
+		uint64_t remaining = header.m_used;
+		uint64_t recordCount = 0;
+
+		while (remaining >= RecordHeaderSize)
+		{
+			uint32_t recordLength = 0;
+			std::memcpy (&recordLength, &pData[offset], sizeof (recordLength));
+
+			uint64_t recordSize = (recordLength == WrapMarker) ?
+				header.m_capacity - offset : AlignRecord (RecordHeaderSize + recordLength);
+
+			// Stop at anything that does not fit rather than read past the data area
+			if (recordSize > remaining || offset + recordSize > header.m_capacity) break;
+
+			if (recordLength != WrapMarker)
+			{
+				recordHandler (std::span<const uint8_t> (&pData[offset + RecordHeaderSize], recordLength));
+				++recordCount;
+			}
+
+			remaining -= recordSize;
+			offset += recordSize;
+			if (offset >= header.m_capacity) offset = 0;
+		}
+
+		return recordCount;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	uint64_t RingLogFile::ForEachRecord (const RecordHandler& recordHandler) noexcept
+	{
+		if (!IsOpen ()) return 0;
+
+		std::scoped_lock lock (m_writeMutex);
+		return WalkRecords (*m_pHeader, m_pData, recordHandler);
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	///
+
+	bool RingLogFile::ReadRecords (const std::string& pathName, const RecordHandler& recordHandler) noexcept
+	{
+		MappedFile mappedFile;
+
+		if (!mappedFile.Open (pathName, MappedFile::Access::Sequential)) return false;
+
+		std::span<const uint8_t> mapping = mappedFile.GetData ();
+		if (mapping.size () < sizeof (Header)) return false;
+
+		// Take a copy of the header so a live writer cannot change it mid walk
+		Header header {};
+		std::memcpy (&header, mapping.data (), sizeof (header));
+
+		if (!IsValidHeader (header, mapping.size ()))
+		{
+			spdlog::error ("Ring log {0} has an invalid header", pathName);
+			return false;
+		}
+
+		(void)WalkRecords (header, mapping.data () + sizeof (Header), recordHandler);
+		return true;
+	}
+}
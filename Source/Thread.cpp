@@ -61,6 +61,10 @@ namespace spc
 			return;
 		}
 
+		// Marked as running before the thread exists so a stop straight away
+		// is not lost
+		m_stopped = false;
+		m_running = true;
 		m_thread = std::thread (&Thread::ThreadWrapper, this);
 	}
 
@@ -78,6 +82,12 @@ namespace spc
 	void Thread::StopExecution ()
 	{
 		m_running = false;
+
+		// Stopping from the thread itself just lets the loop finish this pass
+		if (m_thread.get_id () == std::this_thread::get_id ()) return;
+
+		// A std::thread must be joined before it is destroyed or reassigned
+		if (m_thread.joinable ()) m_thread.join ();
 		while (!m_stopped) usleep (StoppingWaitus);
 	}
 
@@ -86,9 +96,6 @@ namespace spc
 
 	void Thread::ThreadWrapper ()
 	{
-		m_stopped = false;
-		m_running = true;
-
 		spdlog::trace ("Thread {0} starting", m_threadName);
 		ThreadStart ();
 		spdlog::trace ("Thread {0} started", m_threadName);